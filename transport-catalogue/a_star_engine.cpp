@@ -0,0 +1,242 @@
+#include "a_star_engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace catalogue {
+
+	namespace {
+		constexpr double NOT_REACHED = std::numeric_limits<double>::infinity();
+		constexpr graph::EdgeId NO_EDGE = std::numeric_limits<graph::EdgeId>::max();
+		// Keeps the geometric bound below the true one despite the rounding
+		// of ComputeDistance
+		constexpr double BOUND_MARGIN = 1 - 1e-6;
+
+		using Graph = RouteEngine::Graph;
+
+		// Weights of the routes from source to every vertex or, over the
+		// reversed edges given by incoming, from every vertex to source.
+		// incoming[v] holds the positions of the edges entering v
+		std::vector<double> ComputeWeights(const Graph& graph, graph::VertexId source,
+			const std::vector<std::vector<uint32_t>>* incoming) {
+			struct Item {
+				double weight;
+				graph::VertexId vertex;
+
+				bool operator<(const Item& other) const {
+					return weight < other.weight || (weight == other.weight && vertex < other.vertex);
+				}
+			};
+
+			std::vector<double> weights(graph.GetVertexCount(), NOT_REACHED);
+			DaryHeap<Item> heap;
+			weights[source] = 0;
+			heap.Push({ 0, source });
+
+			auto relax = [&](graph::VertexId vertex, double weight) {
+				if (weight < weights[vertex]) {
+					weights[vertex] = weight;
+					heap.Push({ weight, vertex });
+				}
+			};
+
+			while (!heap.Empty()) {
+				const Item item = heap.Top();
+				heap.Pop();
+				if (item.weight > weights[item.vertex]) {
+					continue;
+				}
+				if (incoming) {
+					for (const uint32_t position : (*incoming)[item.vertex]) {
+						relax(graph.GetEdgeFrom(graph.GetEdgeId(position)), item.weight + graph.GetWeight(position));
+					}
+				}
+				else {
+					const uint32_t end = graph.GetFirstEdge(item.vertex + 1);
+					for (uint32_t position = graph.GetFirstEdge(item.vertex); position < end; ++position) {
+						relax(graph.GetTarget(position), item.weight + graph.GetWeight(position));
+					}
+				}
+			}
+			return weights;
+		}
+	}
+
+	AStarEngine::AStarEngine(const Graph& graph, std::vector<geo::Coordinates> vertex_coordinates,
+		size_t landmark_count)
+		: graph_(graph)
+		, coordinates_(std::move(vertex_coordinates))
+		, weights_(graph.GetVertexCount(), NOT_REACHED)
+		, bounds_(graph.GetVertexCount(), 0)
+		, prev_edges_(graph.GetVertexCount(), NO_EDGE) {
+		const size_t vertex_count = graph.GetVertexCount();
+		if (coordinates_.size() != vertex_count) {
+			throw std::invalid_argument("every vertex needs coordinates");
+		}
+
+		min_weight_per_meter_ = NOT_REACHED;
+		std::vector<std::vector<uint32_t>> incoming(landmark_count > 0 ? vertex_count : 0);
+		for (graph::VertexId from = 0; from < vertex_count; ++from) {
+			for (uint32_t position = graph.GetFirstEdge(from); position < graph.GetFirstEdge(from + 1); ++position) {
+				const graph::VertexId to = graph.GetTarget(position);
+				const double weight = graph.GetWeight(position);
+				if (weight < 0) {
+					throw std::domain_error("Edges' weights should be non-negative");
+				}
+				const double distance = geo::ComputeDistance(coordinates_[from], coordinates_[to]);
+				if (distance > 0) {
+					min_weight_per_meter_ = std::min(min_weight_per_meter_, weight / distance);
+				}
+				if (!incoming.empty()) {
+					incoming[to].push_back(position);
+				}
+			}
+		}
+		min_weight_per_meter_ = min_weight_per_meter_ == NOT_REACHED ? 0 : min_weight_per_meter_ * BOUND_MARGIN;
+
+		const std::vector<graph::VertexId> landmarks = SelectLandmarks(landmark_count);
+		if (landmarks.empty()) {
+			return;
+		}
+		landmark_count_ = landmarks.size();
+		from_landmarks_.reserve(landmark_count_ * vertex_count);
+		to_landmarks_.reserve(landmark_count_ * vertex_count);
+		for (const graph::VertexId landmark : landmarks) {
+			const std::vector<double> from = ComputeWeights(graph, landmark, nullptr);
+			const std::vector<double> to = ComputeWeights(graph, landmark, &incoming);
+			from_landmarks_.insert(from_landmarks_.end(), from.begin(), from.end());
+			to_landmarks_.insert(to_landmarks_.end(), to.begin(), to.end());
+		}
+	}
+
+	// The vertex farthest from the centre of the map in each of count equal
+	// angles around it
+	std::vector<graph::VertexId> AStarEngine::SelectLandmarks(size_t count) const {
+		if (count == 0 || coordinates_.empty()) {
+			return {};
+		}
+
+		geo::Coordinates centre{ 0, 0 };
+		for (const geo::Coordinates& coordinates : coordinates_) {
+			centre.lat += coordinates.lat;
+			centre.lng += coordinates.lng;
+		}
+		centre.lat /= coordinates_.size();
+		centre.lng /= coordinates_.size();
+
+		const double pi = std::acos(-1);
+		std::vector<graph::VertexId> farthest(count, NO_EDGE);
+		std::vector<double> farthest_distances(count, -1);
+		for (graph::VertexId vertex = 0; vertex < coordinates_.size(); ++vertex) {
+			const double angle = std::atan2(coordinates_[vertex].lat - centre.lat, coordinates_[vertex].lng - centre.lng);
+			const size_t sector = std::min(count - 1, static_cast<size_t>((angle + pi) / (2 * pi) * count));
+			const double distance = geo::ComputeDistance(centre, coordinates_[vertex]);
+			if (distance > farthest_distances[sector]) {
+				farthest_distances[sector] = distance;
+				farthest[sector] = vertex;
+			}
+		}
+
+		farthest.erase(std::remove(farthest.begin(), farthest.end(), NO_EDGE), farthest.end());
+		return farthest;
+	}
+
+	// Every part of the bound is not more than the weight of the lightest
+	// route from vertex to to; infinity if there is no such route
+	double AStarEngine::ComputeBound(graph::VertexId vertex, graph::VertexId to) const {
+		double bound = min_weight_per_meter_ * geo::ComputeDistance(coordinates_[vertex], coordinates_[to]);
+
+		const size_t vertex_count = coordinates_.size();
+		for (size_t landmark = 0; landmark < landmark_count_; ++landmark) {
+			const double* from_landmark = &from_landmarks_[landmark * vertex_count];
+			const double* to_landmark = &to_landmarks_[landmark * vertex_count];
+			// route(landmark, to) <= route(landmark, vertex) + route(vertex, to)
+			if (from_landmark[vertex] != NOT_REACHED && from_landmark[to] != NOT_REACHED) {
+				bound = std::max(bound, from_landmark[to] - from_landmark[vertex]);
+			}
+			// route(vertex, landmark) <= route(vertex, to) + route(to, landmark)
+			if (to_landmark[to] != NOT_REACHED) {
+				if (to_landmark[vertex] == NOT_REACHED) {
+					return NOT_REACHED;
+				}
+				bound = std::max(bound, to_landmark[vertex] - to_landmark[to]);
+			}
+		}
+		return bound;
+	}
+
+	std::optional<AStarEngine::RouteInfo> AStarEngine::BuildRoute(
+		graph::VertexId from, graph::VertexId to) const {
+		if (from >= weights_.size() || to >= weights_.size()) {
+			throw std::out_of_range("unknown vertex");
+		}
+
+		std::lock_guard lock(mutex_);
+		ResetSearch();
+
+		auto reach = [&](graph::VertexId vertex, double weight, graph::EdgeId edge_id) {
+			if (weights_[vertex] == NOT_REACHED) {
+				reached_.push_back(vertex);
+				bounds_[vertex] = ComputeBound(vertex, to);
+			}
+			weights_[vertex] = weight;
+			prev_edges_[vertex] = edge_id;
+			if (bounds_[vertex] != NOT_REACHED) {
+				heap_.Push({ weight + bounds_[vertex], static_cast<uint32_t>(vertex) });
+			}
+		};
+
+		reach(from, 0, NO_EDGE);
+		while (!heap_.Empty()) {
+			const HeapItem item = heap_.Top();
+			heap_.Pop();
+			const double weight = weights_[item.vertex];
+			if (item.key > weight + bounds_[item.vertex]) {
+				continue;
+			}
+			++settled_count_;
+			if (item.vertex == to) {
+				break;
+			}
+
+			const uint32_t end = graph_.GetFirstEdge(item.vertex + 1);
+			for (uint32_t position = graph_.GetFirstEdge(item.vertex); position < end; ++position) {
+				const graph::VertexId next = graph_.GetTarget(position);
+				if (weight + graph_.GetWeight(position) < weights_[next]) {
+					reach(next, weight + graph_.GetWeight(position), graph_.GetEdgeId(position));
+				}
+			}
+		}
+
+		if (weights_[to] == NOT_REACHED) {
+			return std::nullopt;
+		}
+
+		std::vector<graph::EdgeId> edges;
+		for (graph::VertexId vertex = to; vertex != from; vertex = graph_.GetEdgeFrom(edges.back())) {
+			edges.push_back(prev_edges_[vertex]);
+		}
+		std::reverse(edges.begin(), edges.end());
+
+		return RouteInfo{ weights_[to], std::move(edges) };
+	}
+
+	size_t AStarEngine::GetSettledCount() const {
+		std::lock_guard lock(mutex_);
+		return settled_count_;
+	}
+
+	void AStarEngine::ResetSearch() const {
+		for (const graph::VertexId vertex : reached_) {
+			weights_[vertex] = NOT_REACHED;
+			prev_edges_[vertex] = NO_EDGE;
+		}
+		reached_.clear();
+		heap_.Clear();
+		settled_count_ = 0;
+	}
+
+} // namespace catalogue
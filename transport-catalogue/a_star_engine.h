@@ -0,0 +1,68 @@
+#pragma once
+
+#include "dary_heap.h"
+#include "geo.h"
+#include "route_engine.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace catalogue {
+
+	// Dijkstra's search directed to the last stop: vertices are taken in the
+	// order of their weight plus a lower bound of the weight left. The bound
+	// is the distance to the last stop as the crow flies, times the least
+	// weight per meter among the edges of the graph, so it holds whatever
+	// the road distances are. With landmarks the bound also comes from the
+	// weights of the routes to and from a few vertices on the edge of the
+	// map (ALT), which helps where the roads are much longer than the
+	// straight lines
+	class AStarEngine final : public RouteEngine {
+	public:
+		// vertex_coordinates[v] is where vertex v is
+		AStarEngine(const Graph& graph, std::vector<geo::Coordinates> vertex_coordinates,
+			size_t landmark_count);
+
+		std::optional<RouteInfo> BuildRoute(graph::VertexId from, graph::VertexId to) const override;
+		size_t GetSettledCount() const override;
+
+	private:
+		struct HeapItem {
+			// weight of the vertex plus its bound
+			double key;
+			uint32_t vertex;
+
+			bool operator<(const HeapItem& other) const {
+				return key < other.key || (key == other.key && vertex < other.vertex);
+			}
+		};
+
+		const Graph& graph_;
+		std::vector<geo::Coordinates> coordinates_;
+		double min_weight_per_meter_ = 0;
+
+		// Row l holds the weights of the routes from landmark l to every
+		// vertex and from every vertex to landmark l
+		size_t landmark_count_ = 0;
+		std::vector<double> from_landmarks_;
+		std::vector<double> to_landmarks_;
+
+		// Search state, kept between requests. Only the vertices reached by
+		// the previous search are reset
+		mutable std::mutex mutex_;
+		mutable std::vector<double> weights_;
+		mutable std::vector<double> bounds_;
+		mutable std::vector<graph::EdgeId> prev_edges_;
+		mutable std::vector<graph::VertexId> reached_;
+		mutable DaryHeap<HeapItem> heap_;
+		mutable size_t settled_count_ = 0;
+
+		std::vector<graph::VertexId> SelectLandmarks(size_t count) const;
+		double ComputeBound(graph::VertexId vertex, graph::VertexId to) const;
+		void ResetSearch() const;
+	};
+
+} // namespace catalogue
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+namespace bench {
+
+    // Генерирует входной документ каталога в формате задачи: stop_count
+    // остановок с расстояниями до соседей, автобусы по 10 остановок и
+    // запросы Bus, Stop и Route. Документ одинаков при одинаковых параметрах
+    inline std::string MakeCatalogueInput(size_t stop_count, uint32_t seed = 1) {
+        uint64_t state = seed;
+        auto next = [&state] {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<uint32_t>(state >> 33);
+        };
+        auto stop_name = [](size_t stop) {
+            return "Stop " + std::to_string(stop);
+        };
+
+        std::string out;
+        out.reserve(stop_count * 200);
+        out += "{\"base_requests\": [\n";
+        for (size_t stop = 0; stop < stop_count; ++stop) {
+            out += "{\"type\": \"Stop\", \"name\": \"" + stop_name(stop) + "\", \"latitude\": 55.";
+            out += std::to_string(500000 + next() % 200000);
+            out += ", \"longitude\": 37.";
+            out += std::to_string(500000 + next() % 200000);
+            out += ", \"road_distances\": {";
+            // три разных соседа подряд со случайного сдвига, ключи не повторяются
+            const size_t shift = stop_count > 1 ? next() % (stop_count - 1) : 0;
+            for (size_t i = 0; i < 3 && i + 1 < stop_count; ++i) {
+                if (i > 0) {
+                    out += ", ";
+                }
+                out += "\"" + stop_name((stop + 1 + (shift + i) % (stop_count - 1)) % stop_count) + "\": ";
+                out += std::to_string(500 + next() % 4500);
+            }
+            out += "}},\n";
+        }
+        const size_t bus_count = stop_count / 10 + 1;
+        for (size_t bus = 0; bus < bus_count; ++bus) {
+            out += "{\"type\": \"Bus\", \"name\": \"Bus " + std::to_string(bus) + "\", \"is_roundtrip\": ";
+            out += (bus % 2 == 0) ? "true" : "false";
+            out += ", \"stops\": [";
+            for (size_t i = 0; i < 10; ++i) {
+                if (i > 0) {
+                    out += ", ";
+                }
+                out += "\"" + stop_name(next() % stop_count) + "\"";
+            }
+            out += (bus + 1 < bus_count) ? "]},\n" : "]}\n";
+        }
+        out += "],\n\"render_settings\": {\"width\": 1200, \"height\": 1200, \"padding\": 50, "
+            "\"line_width\": 14, \"stop_radius\": 5, \"bus_label_font_size\": 20, "
+            "\"bus_label_offset\": [7, 15], \"stop_label_font_size\": 20, "
+            "\"stop_label_offset\": [7, -3], \"underlayer_color\": [255, 255, 255, 0.85], "
+            "\"underlayer_width\": 3, \"color_palette\": [\"green\", [255, 160, 0], \"red\"]},\n"
+            "\"routing_settings\": {\"bus_wait_time\": 6, \"bus_velocity\": 40},\n"
+            "\"stat_requests\": [\n";
+        const size_t request_count = stop_count / 10 + 1;
+        for (size_t id = 0; id < request_count; ++id) {
+            out += "{\"id\": " + std::to_string(id) + ", ";
+            switch (id % 3) {
+            case 0:
+                out += "\"type\": \"Bus\", \"name\": \"Bus " + std::to_string(next() % bus_count) + "\"";
+                break;
+            case 1:
+                out += "\"type\": \"Stop\", \"name\": \"" + stop_name(next() % stop_count) + "\"";
+                break;
+            default:
+                out += "\"type\": \"Route\", \"from\": \"" + stop_name(next() % stop_count)
+                    + "\", \"to\": \"" + stop_name(next() % stop_count) + "\"";
+            }
+            out += (id + 1 < request_count) ? "},\n" : "}\n";
+        }
+        out += "]}\n";
+        return out;
+    }
+
+    // SVG карты: polyline_count ломаных по 20 точек и вчетверо больше
+    // остановок с кружком и подписью. В атрибутах много кавычек
+    inline std::string MakeSvg(size_t polyline_count, uint64_t& state) {
+        auto next = [&state] {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<uint32_t>(state >> 33);
+        };
+        auto coordinate = [&next] {
+            return std::to_string(next() % 1200) + "." + std::to_string(next() % 1000000);
+        };
+
+        std::string svg = "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"
+            "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n";
+        for (size_t line = 0; line < polyline_count; ++line) {
+            svg += "  <polyline points=\"";
+            for (size_t point = 0; point < 20; ++point) {
+                if (point > 0) {
+                    svg += ' ';
+                }
+                svg += coordinate() + "," + coordinate();
+            }
+            svg += "\" fill=\"none\" stroke=\"green\" stroke-width=\"14\" "
+                "stroke-linecap=\"round\" stroke-linejoin=\"round\"/>\n";
+        }
+        for (size_t stop = 0; stop < polyline_count * 4; ++stop) {
+            const std::string x = coordinate();
+            const std::string y = coordinate();
+            svg += "  <circle cx=\"" + x + "\" cy=\"" + y + "\" r=\"5\" fill=\"white\"/>\n";
+            svg += "  <text fill=\"black\" x=\"" + x + "\" y=\"" + y + "\" dx=\"7\" dy=\"-3\" "
+                "font-size=\"20\" font-family=\"Verdana\">Stop " + std::to_string(stop) + "</text>\n";
+        }
+        svg += "</svg>";
+        return svg;
+    }
+
+    inline std::string ReadFile(const std::string& path) {
+        std::ifstream input(path, std::ios::binary);
+        if (!input) {
+            throw std::runtime_error("Can't open " + path);
+        }
+        return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+
+    // Лучшее время из repeat запусков в миллисекундах
+    template <typename Function>
+    double MeasureMs(int repeat, Function function) {
+        double best = 0;
+        for (int run = 0; run < repeat; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            function();
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            if (run == 0 || elapsed.count() < best) {
+                best = elapsed.count();
+            }
+        }
+        return best;
+    }
+
+}  // namespace bench
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+    // Заполняет каталог сетью, похожей на город: stop_count остановок в узлах
+    // квадратной сетки с шагом около 300 м и stop_count / 5 автобусов,
+    // каждый из которых идёт через 20 соседних остановок туда и обратно.
+    // Расстояния по дорогам от 200 до 600 м. Сеть одинакова при одинаковых
+    // параметрах
+    inline void FillCityNetwork(catalogue::TransportCatalogue& catalogue, size_t stop_count, uint32_t seed = 1) {
+        uint64_t state = seed;
+        auto next = [&state] {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<uint32_t>(state >> 33);
+        };
+
+        size_t side = 1;
+        while ((side + 1) * (side + 1) <= stop_count) {
+            ++side;
+        }
+        std::vector<catalogue::StopId> grid(side * side);
+        for (size_t cell = 0; cell < grid.size(); ++cell) {
+            grid[cell] = catalogue.AddStop(catalogue::Stop{ "Stop " + std::to_string(cell),
+                { 55.5 + 0.0027 * (cell / side), 37.3 + 0.0047 * (cell % side) } });
+        }
+
+        const size_t bus_count = grid.size() / 5;
+        std::vector<std::vector<catalogue::StopId>> buses(bus_count);
+        for (auto& stops : buses) {
+            size_t row = next() % side;
+            size_t column = next() % side;
+            std::vector<size_t> cells{ row * side + column };
+            for (size_t step = 0; step < 40 && cells.size() < 20; ++step) {
+                size_t next_row = row;
+                size_t next_column = column;
+                switch (next() % 4) {
+                case 0: next_row += 1; break;
+                case 1: next_row -= 1; break;
+                case 2: next_column += 1; break;
+                default: next_column -= 1;
+                }
+                const size_t cell = next_row * side + next_column;
+                bool visited = false;
+                for (const size_t visited_cell : cells) {
+                    visited = visited || visited_cell == cell;
+                }
+                if (next_row >= side || next_column >= side || visited) {
+                    continue;
+                }
+                // из двух автобусов по одной улице расстояние задаёт первый
+                catalogue.SetDistance(grid[cells.back()], grid[cell], 200 + next() % 400);
+                row = next_row;
+                column = next_column;
+                cells.push_back(cell);
+            }
+            for (const size_t cell : cells) {
+                stops.push_back(grid[cell]);
+            }
+        }
+
+        // Прямой маршрут хранит путь туда и обратно
+        for (size_t bus = 0; bus < bus_count; ++bus) {
+            std::vector<catalogue::StopId> stops = buses[bus];
+            stops.insert(stops.end(), buses[bus].rbegin() + 1, buses[bus].rend());
+            catalogue.AddBus(catalogue::Bus{ catalogue::TypeRoute::DIRECT, "Bus " + std::to_string(bus),
+                std::move(stops), {} });
+        }
+    }
+
+    // Занятая процессом память в МБ, 0 вне Linux
+    inline double GetRssMb() {
+        std::ifstream status("/proc/self/status");
+        std::string key;
+        while (status >> key) {
+            if (key == "VmRSS:") {
+                double kilobytes = 0;
+                status >> kilobytes;
+                return kilobytes / 1024;
+            }
+        }
+        return 0;
+    }
+
+}  // namespace bench
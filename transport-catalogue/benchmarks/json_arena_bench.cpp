@@ -0,0 +1,148 @@
+// Время загрузки и уничтожения документа и число выделений памяти при загрузке:
+// дерево в арене документа против дерева, где каждый узел выделяется в куче.
+//
+// Сборка из каталога benchmarks:
+//   g++ -std=c++17 -O2 -I.. json_arena_bench.cpp ../json.cpp ../simd_scan.cpp -o json_arena_bench
+// Запуск: ./json_arena_bench [число остановок] [файлы JSON...]
+// По умолчанию генерируется вход на 1 000 000 остановок
+
+#include "bench_input.h"
+#include "json.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <string>
+
+namespace {
+
+    size_t allocation_count = 0;
+    size_t allocated_bytes = 0;
+
+}  // namespace
+
+// Глобальные operator new/delete подменены, чтобы считать выделения.
+// Арена берёт блоки у new_delete_resource, то есть тоже через operator new
+// (polymorphic_allocator вызывает вариант с выравниванием)
+void* operator new(std::size_t size) {
+    ++allocation_count;
+    allocated_bytes += size;
+    if (void* p = std::malloc(size == 0 ? 1 : size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    ++allocation_count;
+    allocated_bytes += size;
+    const size_t alignment = static_cast<size_t>(align);
+    // aligned_alloc требует размер, кратный выравниванию
+    if (void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+    using namespace std::literals;
+    using Clock = std::chrono::steady_clock;
+
+    struct Result {
+        double load_ms = 0;
+        double destroy_ms = 0;
+        size_t allocations = 0;
+        size_t bytes = 0;
+    };
+
+    double ElapsedMs(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    // Лучшие времена из repeat запусков. Load строит документ в переданном
+    // optional, уничтожение замеряется отдельно вызовом reset()
+    template <typename Tree, typename Load>
+    Result Measure(int repeat, Load load) {
+        Result best;
+        for (int run = 0; run < repeat; ++run) {
+            std::optional<Tree> tree;
+            const size_t count_before = allocation_count;
+            const size_t bytes_before = allocated_bytes;
+
+            auto start = Clock::now();
+            load(tree);
+            const double load_ms = ElapsedMs(start);
+            const size_t allocations = allocation_count - count_before;
+            const size_t bytes = allocated_bytes - bytes_before;
+
+            start = Clock::now();
+            tree.reset();
+            const double destroy_ms = ElapsedMs(start);
+
+            if (run == 0 || load_ms < best.load_ms) {
+                best.load_ms = load_ms;
+            }
+            if (run == 0 || destroy_ms < best.destroy_ms) {
+                best.destroy_ms = destroy_ms;
+            }
+            best.allocations = allocations;
+            best.bytes = bytes;
+        }
+        return best;
+    }
+
+    void Print(std::string_view title, const Result& result) {
+        std::cout << "  "sv << std::left << std::setw(10) << title << std::right << std::fixed << std::setprecision(1)
+            << "load "sv << std::setw(8) << result.load_ms << " ms, destroy "sv << std::setw(7) << result.destroy_ms
+            << " ms, allocations "sv << std::setw(9) << result.allocations
+            << ", "sv << std::setw(7) << result.bytes / 1e6 << " MB requested\n"sv;
+        std::cout.copyfmt(std::ios(nullptr));
+    }
+
+    void Run(const std::string& name, const std::string& text, int repeat) {
+        std::cout << name << ", "sv << text.size() / 1e6 << " MB\n"sv;
+
+        const Result arena = Measure<json::Document>(repeat, [&](std::optional<json::Document>& tree) {
+            tree.emplace(json::Load(std::string_view(text)));
+        });
+        Print("arena"sv, arena);
+
+        // Тот же разбор, но каждый контейнер и строка выделяются отдельно
+        const Result heap = Measure<json::Node>(repeat, [&](std::optional<json::Node>& tree) {
+            json::TreeBuilder builder(std::pmr::new_delete_resource());
+            json::Parse(std::string_view(text), builder);
+            tree.emplace(builder.Extract());
+        });
+        Print("heap"sv, heap);
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t stop_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    for (int i = 2; i < argc; ++i) {
+        Run(argv[i], bench::ReadFile(argv[i]), 5);
+    }
+    Run("generated, "s + std::to_string(stop_count) + " stops"s, bench::MakeCatalogueInput(stop_count), 2);
+}
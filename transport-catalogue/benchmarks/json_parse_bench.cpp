@@ -0,0 +1,250 @@
+// Сравнивает разбор JSON посимвольным чтением из std::istream, как json::Load
+// работал раньше, с разбором непрерывного буфера.
+//
+// Сборка из каталога benchmarks:
+//   g++ -std=c++17 -O2 -I.. json_parse_bench.cpp ../json.cpp ../simd_scan.cpp -o json_parse_bench
+// Запуск: ./json_parse_bench [число остановок] [файлы JSON...]
+
+#include "bench_input.h"
+#include "json.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+    using namespace std::literals;
+
+    // Прежний разбор: peek()/get() по одному символу, строки через
+    // istreambuf_iterator, числа через std::stoi/std::stod. События
+    // отдаются тому же TreeBuilder, так что различается только чтение
+    class IstreamParser {
+    public:
+        IstreamParser(std::istream& input, json::Handler& handler)
+            : input_(input)
+            , handler_(handler) {
+        }
+
+        void ParseNode() {
+            char c;
+            if (!(input_ >> c)) {
+                throw json::ParsingError("Unexpected EOF"s);
+            }
+            switch (c) {
+            case '[':
+                ParseArray();
+                break;
+            case '{':
+                ParseDict();
+                break;
+            case '"':
+                handler_.String(ParseString());
+                break;
+            case 't':
+            case 'f':
+                input_.putback(c);
+                ParseBool();
+                break;
+            case 'n':
+                input_.putback(c);
+                if (ParseLiteral() != "null"sv) {
+                    throw json::ParsingError("Failed to parse null"s);
+                }
+                handler_.Null();
+                break;
+            default:
+                input_.putback(c);
+                ParseNumber();
+            }
+        }
+
+    private:
+        std::istream& input_;
+        json::Handler& handler_;
+
+        std::string ParseLiteral() {
+            std::string s;
+            while (std::isalpha(input_.peek())) {
+                s.push_back(static_cast<char>(input_.get()));
+            }
+            return s;
+        }
+
+        void ParseBool() {
+            const std::string s = ParseLiteral();
+            if (s == "true"sv) {
+                handler_.Bool(true);
+            }
+            else if (s == "false"sv) {
+                handler_.Bool(false);
+            }
+            else {
+                throw json::ParsingError("Failed to parse '"s + s + "' as bool"s);
+            }
+        }
+
+        void ParseArray() {
+            handler_.StartArray();
+            for (char c; input_ >> c && c != ']';) {
+                if (c != ',') {
+                    input_.putback(c);
+                }
+                ParseNode();
+            }
+            if (!input_) {
+                throw json::ParsingError("Array parsing error"s);
+            }
+            handler_.EndArray();
+        }
+
+        void ParseDict() {
+            handler_.StartDict();
+            for (char c; input_ >> c && c != '}';) {
+                if (c == ',') {
+                    continue;
+                }
+                if (c != '"') {
+                    throw json::ParsingError("',' is expected"s);
+                }
+                handler_.Key(ParseString());
+                if (!(input_ >> c) || c != ':') {
+                    throw json::ParsingError("':' is expected"s);
+                }
+                ParseNode();
+            }
+            if (!input_) {
+                throw json::ParsingError("Dictionary parsing error"s);
+            }
+            handler_.EndDict();
+        }
+
+        std::string ParseString() {
+            auto it = std::istreambuf_iterator<char>(input_);
+            const auto end = std::istreambuf_iterator<char>();
+            std::string s;
+            while (true) {
+                if (it == end) {
+                    throw json::ParsingError("String parsing error"s);
+                }
+                const char ch = *it;
+                if (ch == '"') {
+                    ++it;
+                    break;
+                }
+                if (ch == '\\') {
+                    ++it;
+                    if (it == end) {
+                        throw json::ParsingError("String parsing error"s);
+                    }
+                    switch (*it) {
+                    case 'n': s.push_back('\n'); break;
+                    case 't': s.push_back('\t'); break;
+                    case 'r': s.push_back('\r'); break;
+                    case '"': s.push_back('"'); break;
+                    case '\\': s.push_back('\\'); break;
+                    default: throw json::ParsingError("Unrecognized escape sequence"s);
+                    }
+                }
+                else {
+                    s.push_back(ch);
+                }
+                ++it;
+            }
+            return s;
+        }
+
+        void ParseNumber() {
+            std::string parsed_num;
+            auto read_digits = [&] {
+                if (!std::isdigit(input_.peek())) {
+                    throw json::ParsingError("A digit is expected"s);
+                }
+                while (std::isdigit(input_.peek())) {
+                    parsed_num += static_cast<char>(input_.get());
+                }
+            };
+
+            if (input_.peek() == '-') {
+                parsed_num += static_cast<char>(input_.get());
+            }
+            if (input_.peek() == '0') {
+                parsed_num += static_cast<char>(input_.get());
+            }
+            else {
+                read_digits();
+            }
+            bool is_int = true;
+            if (input_.peek() == '.') {
+                parsed_num += static_cast<char>(input_.get());
+                read_digits();
+                is_int = false;
+            }
+            if (int ch = input_.peek(); ch == 'e' || ch == 'E') {
+                parsed_num += static_cast<char>(input_.get());
+                if (ch = input_.peek(); ch == '+' || ch == '-') {
+                    parsed_num += static_cast<char>(input_.get());
+                }
+                read_digits();
+                is_int = false;
+            }
+
+            if (is_int) {
+                try {
+                    handler_.Int(std::stoi(parsed_num));
+                    return;
+                }
+                catch (...) {
+                    // при переполнении int число читается как double
+                }
+            }
+            handler_.Double(std::stod(parsed_num));
+        }
+    };
+
+    json::Node LoadByChar(const std::string& text) {
+        std::istringstream input(text);
+        json::TreeBuilder builder;
+        IstreamParser(input, builder).ParseNode();
+        return builder.Extract();
+    }
+
+    void Run(const std::string& name, const std::string& text) {
+        constexpr int REPEAT = 3;
+        const double megabytes = text.size() / 1e6;
+
+        if (LoadByChar(text) != json::Load(std::string_view(text)).GetRoot()) {
+            std::cerr << name << ": documents differ"sv << std::endl;
+            std::exit(1);
+        }
+
+        const double by_char = bench::MeasureMs(REPEAT, [&] {
+            LoadByChar(text);
+        });
+        const double from_stream = bench::MeasureMs(REPEAT, [&] {
+            std::istringstream input(text);
+            json::Load(input);
+        });
+        const double from_buffer = bench::MeasureMs(REPEAT, [&] {
+            json::Load(std::string_view(text));
+        });
+
+        std::cout << name << ", "sv << megabytes << " MB\n"sv;
+        std::cout << "  istream, by char:       "sv << by_char << " ms, "sv << megabytes / by_char * 1000 << " MB/s\n"sv;
+        std::cout << "  Load(istream&), buffer: "sv << from_stream << " ms, "sv << megabytes / from_stream * 1000 << " MB/s\n"sv;
+        std::cout << "  Load(string_view):      "sv << from_buffer << " ms, "sv << megabytes / from_buffer * 1000 << " MB/s\n"sv;
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t stop_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    Run("generated, "s + std::to_string(stop_count) + " stops"s, bench::MakeCatalogueInput(stop_count));
+    for (int i = 2; i < argc; ++i) {
+        Run(argv[i], bench::ReadFile(argv[i]));
+    }
+}
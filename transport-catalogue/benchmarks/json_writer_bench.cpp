@@ -0,0 +1,144 @@
+// Скорость вывода json::Writer в форматах PRETTY и COMPACT на документе,
+// похожем на ответ каталога: ответы Bus, Stop и Route и несколько ответов
+// Map с большими строками SVG, в которых много кавычек и переводов строк.
+//
+// Сборка из каталога benchmarks:
+//   g++ -std=c++17 -O2 -I.. json_writer_bench.cpp ../json.cpp ../simd_scan.cpp -o json_writer_bench
+// Запуск: ./json_writer_bench [число ответов] [число ответов Map]
+
+#include "bench_input.h"
+#include "json.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <streambuf>
+#include <string>
+
+namespace {
+
+    using namespace std::literals;
+
+    // Поток, который только считает выведенные символы
+    class CountingBuffer : public std::streambuf {
+    public:
+        size_t Count() const {
+            return count_;
+        }
+
+    protected:
+        int_type overflow(int_type c) override {
+            if (!traits_type::eq_int_type(c, traits_type::eof())) {
+                ++count_;
+            }
+            return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(const char*, std::streamsize n) override {
+            count_ += static_cast<size_t>(n);
+            return n;
+        }
+
+    private:
+        size_t count_ = 0;
+    };
+
+    // Документ собирается через TreeBuilder в куче, без арены
+    json::Node MakeAnswers(size_t answer_count, size_t map_count) {
+        uint64_t state = 1;
+        auto next = [&state] {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<uint32_t>(state >> 33);
+        };
+
+        json::TreeBuilder builder;
+        builder.StartArray();
+        for (size_t id = 0; id < answer_count; ++id) {
+            builder.StartDict();
+            builder.Key("request_id"sv);
+            builder.Int(static_cast<int>(id));
+            switch (id % 3) {
+            case 0:
+                builder.Key("curvature"sv);
+                builder.Double(1.0 + next() % 100000 / 37.0);
+                builder.Key("route_length"sv);
+                builder.Int(static_cast<int>(next() % 100000));
+                builder.Key("stop_count"sv);
+                builder.Int(static_cast<int>(next() % 50));
+                builder.Key("unique_stop_count"sv);
+                builder.Int(static_cast<int>(next() % 25));
+                break;
+            case 1:
+                builder.Key("buses"sv);
+                builder.StartArray();
+                for (uint32_t i = 0, n = next() % 6; i < n; ++i) {
+                    builder.String("Bus "s + std::to_string(next() % 10000));
+                }
+                builder.EndArray();
+                break;
+            default:
+                builder.Key("items"sv);
+                builder.StartArray();
+                for (uint32_t i = 0, n = next() % 4; i < n; ++i) {
+                    builder.StartDict();
+                    builder.Key("stop_name"sv);
+                    builder.String("Stop "s + std::to_string(next() % 100000));
+                    builder.Key("time"sv);
+                    builder.Int(6);
+                    builder.Key("type"sv);
+                    builder.String("Wait"sv);
+                    builder.EndDict();
+                    builder.StartDict();
+                    builder.Key("bus"sv);
+                    builder.String("Bus "s + std::to_string(next() % 10000));
+                    builder.Key("span_count"sv);
+                    builder.Int(static_cast<int>(next() % 10 + 1));
+                    builder.Key("time"sv);
+                    builder.Double(next() % 100000 / 999.0);
+                    builder.Key("type"sv);
+                    builder.String("Bus"sv);
+                    builder.EndDict();
+                }
+                builder.EndArray();
+                builder.Key("total_time"sv);
+                builder.Double(next() % 1000000 / 999.0);
+            }
+            builder.EndDict();
+        }
+        for (size_t map = 0; map < map_count; ++map) {
+            builder.StartDict();
+            builder.Key("map"sv);
+            builder.String(bench::MakeSvg(1000, state));
+            builder.Key("request_id"sv);
+            builder.Int(static_cast<int>(answer_count + map));
+            builder.EndDict();
+        }
+        builder.EndArray();
+        return builder.Extract();
+    }
+
+    void Run(const json::Node& answers, json::Format format, std::string_view title) {
+        constexpr int REPEAT = 5;
+        size_t written = 0;
+        const double ms = bench::MeasureMs(REPEAT, [&] {
+            CountingBuffer buffer;
+            std::ostream output(&buffer);
+            json::Writer writer(output, format);
+            writer.Value(answers);
+            writer.Flush();
+            written = buffer.Count();
+        });
+        const double megabytes = written / 1e6;
+        std::cout << title << megabytes << " MB in "sv << ms << " ms, "sv << megabytes / ms * 1000 << " MB/s\n"sv;
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t answer_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 300000;
+    const size_t map_count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 10;
+    const json::Node answers = MakeAnswers(answer_count, map_count);
+    std::cout << answer_count << " answers, "sv << map_count << " maps\n"sv;
+    Run(answers, json::Format::PRETTY, "  PRETTY:  "sv);
+    Run(answers, json::Format::COMPACT, "  COMPACT: "sv);
+}
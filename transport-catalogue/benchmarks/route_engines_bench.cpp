@@ -0,0 +1,156 @@
+// Подготовка и запросы движков маршрутизации на сгенерированной сети: время
+// подготовки, прирост занятой памяти, время одного запроса и число вершин,
+// которые поиск обработал за запрос. Все движки отвечают на одни и те же
+// запросы, total_time сверяется с первым движком. Кэш ответов выключен.
+//
+// Сборка из каталога benchmarks (graph.h, router.h и ranges.h лежат рядом с
+// остальными исходниками):
+//   g++ -std=c++17 -O2 -pthread -I.. route_engines_bench.cpp $(ls ../*.cpp | grep -v main.cpp) -o route_engines_bench
+// Запуск: ./route_engines_bench [число остановок] [число запросов] [движки...]
+// Движки: all_pairs, dijkstra, contraction_hierarchies, a_star, alt, raptor;
+// по умолчанию все, кроме all_pairs, которому нужно (2 * остановок)^2 * 12
+// байт. Память, освобождённая предыдущим движком, может достаться
+// следующему, поэтому точнее она видна, когда движок в запуске один
+
+#include "bench_input.h"
+#include "bench_network.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    using namespace std::literals;
+    using catalogue::RouterEngine;
+
+    struct EngineName {
+        std::string_view name;
+        RouterEngine engine;
+    };
+
+    constexpr EngineName ENGINES[] = {
+        { "all_pairs"sv, RouterEngine::ALL_PAIRS },
+        { "dijkstra"sv, RouterEngine::DIJKSTRA },
+        { "contraction_hierarchies"sv, RouterEngine::CONTRACTION_HIERARCHIES },
+        { "a_star"sv, RouterEngine::A_STAR },
+        { "alt"sv, RouterEngine::ALT },
+        { "raptor"sv, RouterEngine::RAPTOR },
+    };
+
+    std::optional<RouterEngine> FindEngine(std::string_view name) {
+        for (const EngineName& engine : ENGINES) {
+            if (engine.name == name) {
+                return engine.engine;
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Пары остановок по именам, одинаковые для всех движков
+    std::vector<std::pair<std::string, std::string>> MakeQueries(
+        const catalogue::TransportCatalogue& catalogue, size_t query_count) {
+        uint64_t state = 2;
+        auto next = [&state] {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<uint32_t>(state >> 33);
+        };
+        const size_t stop_count = catalogue.GetStopCount();
+        std::vector<std::pair<std::string, std::string>> queries;
+        for (size_t i = 0; i < query_count; ++i) {
+            queries.emplace_back(catalogue.GetStopName(next() % stop_count),
+                catalogue.GetStopName(next() % stop_count));
+        }
+        return queries;
+    }
+
+    // total_time первого движка; NAN - маршрута нет
+    std::vector<double> expected_times;
+
+    void Run(std::string_view name, RouterEngine engine, const catalogue::TransportCatalogue& catalogue,
+        const std::vector<std::pair<std::string, std::string>>& queries) {
+        catalogue::RoutingSettings settings;
+        settings.bus_velocity = 500;
+        settings.bus_wait_time = 5;
+        settings.engine = engine;
+        settings.route_cache_size = 0;
+
+        const double rss_before = bench::GetRssMb();
+        catalogue::TransportRouter router(catalogue, settings);
+        const double build_ms = bench::MeasureMs(1, [&] {
+            router.BuildGraphAndRouter();
+        });
+        const double rss_growth = bench::GetRssMb() - rss_before;
+
+        std::vector<double> times;
+        size_t settled = 0;
+        const double query_ms = bench::MeasureMs(1, [&] {
+            times.clear();
+            settled = 0;
+            for (const auto& [from, to] : queries) {
+                const auto route = router.BuildRoute(from, to);
+                times.push_back(route ? route->total_time : NAN);
+                settled += router.GetSettledCount();
+            }
+        });
+
+        size_t mismatches = 0;
+        if (expected_times.empty()) {
+            expected_times = times;
+        }
+        for (size_t i = 0; i < times.size(); ++i) {
+            const bool both_missing = std::isnan(times[i]) && std::isnan(expected_times[i]);
+            if (!both_missing && !(std::abs(times[i] - expected_times[i]) <= 1e-9 * expected_times[i])) {
+                ++mismatches;
+            }
+        }
+
+        std::cout << std::left << std::setw(24) << name << std::right << std::fixed << std::setprecision(1)
+            << std::setw(10) << build_ms << " ms" << std::setw(9) << rss_growth << " MB"
+            << std::setprecision(3) << std::setw(10) << query_ms / queries.size() << " ms";
+        if (engine == RouterEngine::ALL_PAIRS || engine == RouterEngine::RAPTOR) {
+            std::cout << std::setw(12) << "-";
+        }
+        else {
+            std::cout << std::setw(12) << settled / queries.size();
+        }
+        std::cout << std::setw(12) << mismatches << '\n';
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t stop_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    const size_t query_count = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000;
+    std::vector<EngineName> engines;
+    for (int i = 3; i < argc; ++i) {
+        const auto engine = FindEngine(argv[i]);
+        if (!engine) {
+            std::cerr << "Unknown engine: "sv << argv[i] << std::endl;
+            return 1;
+        }
+        engines.push_back({ argv[i], *engine });
+    }
+    if (engines.empty()) {
+        engines.assign(std::begin(ENGINES) + 1, std::end(ENGINES));
+    }
+
+    catalogue::TransportCatalogue catalogue;
+    bench::FillCityNetwork(catalogue, stop_count);
+    const auto queries = MakeQueries(catalogue, query_count);
+    std::cout << catalogue.GetStopCount() << " stops, "sv << catalogue.GetBusCount() << " buses, "sv
+        << queries.size() << " routes\n"sv;
+    std::cout << "engine                     prepare     memory     query     settled  mismatches\n"sv;
+    for (const EngineName& engine : engines) {
+        Run(engine.name, engine.engine, catalogue, queries);
+    }
+}
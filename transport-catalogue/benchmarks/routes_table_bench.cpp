@@ -0,0 +1,106 @@
+// Масштабирование построения таблицы всех кратчайших маршрутов (алгоритм
+// Флойда-Уоршелла в routes_table.cpp) по числу потоков: время построения,
+// ускорение и эффективность относительно одного потока на сгенерированной
+// сети. Таблица обязана быть одинаковой при любом числе потоков, поэтому
+// ответы на одни и те же запросы сверяются с однопоточной таблицей.
+//
+// Сборка из каталога benchmarks (graph.h, router.h и ranges.h лежат рядом с
+// остальными исходниками):
+//   g++ -std=c++17 -O2 -pthread -I.. routes_table_bench.cpp $(ls ../*.cpp | grep -v main.cpp) -o routes_table_bench
+// Запуск: ./routes_table_bench [число остановок] [число потоков...]
+// По умолчанию 1, 2, 4 ... потока вплоть до числа ядер. Таблице нужно
+// (2 * остановок)^2 * 12 байт, время растёт как куб числа остановок
+
+#include "bench_input.h"
+#include "bench_network.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    using namespace std::literals;
+
+    constexpr size_t QUERY_COUNT = 2000;
+
+    // Ответ на запрос: число элементов маршрута и total_time, -1 - маршрута нет
+    using Answer = std::pair<size_t, double>;
+
+    std::vector<Answer> BuildAndAnswer(const catalogue::TransportCatalogue& catalogue, size_t threads,
+        double& build_ms) {
+        catalogue::RoutingSettings settings;
+        settings.bus_velocity = 500;
+        settings.bus_wait_time = 5;
+        settings.engine = catalogue::RouterEngine::ALL_PAIRS;
+        settings.build_threads = threads;
+        settings.route_cache_size = 0;
+
+        catalogue::TransportRouter router(catalogue, settings);
+        build_ms = bench::MeasureMs(1, [&] {
+            router.BuildGraphAndRouter();
+        });
+
+        uint64_t state = 3;
+        auto next = [&state] {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<uint32_t>(state >> 33);
+        };
+        const size_t stop_count = catalogue.GetStopCount();
+        std::vector<Answer> answers;
+        for (size_t i = 0; i < QUERY_COUNT; ++i) {
+            const std::string from(catalogue.GetStopName(next() % stop_count));
+            const std::string to(catalogue.GetStopName(next() % stop_count));
+            const auto route = router.BuildRoute(from, to);
+            answers.push_back(route ? Answer{ route->items.size(), route->total_time } : Answer{ 0, -1 });
+        }
+        return answers;
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t stop_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    std::vector<size_t> thread_counts;
+    for (int i = 2; i < argc; ++i) {
+        thread_counts.push_back(std::max<size_t>(1, std::strtoul(argv[i], nullptr, 10)));
+    }
+    const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    if (thread_counts.empty()) {
+        for (size_t threads = 1; threads < cores; threads *= 2) {
+            thread_counts.push_back(threads);
+        }
+        thread_counts.push_back(cores);
+    }
+
+    catalogue::TransportCatalogue catalogue;
+    bench::FillCityNetwork(catalogue, stop_count);
+    std::cout << catalogue.GetStopCount() << " stops, "sv << catalogue.GetBusCount() << " buses, "sv
+        << cores << " cores\n"sv;
+    std::cout << "threads         build  speedup  efficiency  mismatches\n"sv;
+
+    double single_ms = 0;
+    const std::vector<Answer> expected = BuildAndAnswer(catalogue, 1, single_ms);
+    for (const size_t threads : thread_counts) {
+        double build_ms = single_ms;
+        const std::vector<Answer> answers = threads == 1 ? expected : BuildAndAnswer(catalogue, threads, build_ms);
+
+        size_t mismatches = 0;
+        for (size_t i = 0; i < answers.size(); ++i) {
+            mismatches += answers[i] != expected[i];
+        }
+        const double speedup = single_ms / build_ms;
+        std::cout << std::setw(7) << threads << std::fixed << std::setprecision(1)
+            << std::setw(11) << build_ms << " ms" << std::setprecision(2) << std::setw(9) << speedup
+            << std::setw(11) << speedup / threads * 100 << '%' << std::setw(12) << mismatches << '\n';
+    }
+}
@@ -0,0 +1,131 @@
+// Сравнивает поиск спецсимволов посимвольно, блоками SSE2 и блоками AVX2
+// на длинных названиях остановок и на большом SVG карты. Названия
+// просматриваются так, как их читает json.cpp и экранирует svg.cpp, SVG -
+// так, как json::Writer экранирует ответ Map. Пути поиска лежат в
+// безымянном пространстве имён simd_scan.cpp, поэтому файл включается
+// целиком, а не собирается отдельно.
+//
+// Сборка из каталога benchmarks:
+//   g++ -std=c++17 -O2 -I.. simd_scan_bench.cpp -o simd_scan_bench
+// Запуск: ./simd_scan_bench [размер текста в МБ]
+
+#include "bench_input.h"
+#include "simd_scan.cpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+    using namespace std::literals;
+
+    using FindFunction = const char* (*)(const char*, const char*);
+
+    struct Path {
+        std::string_view name;
+        FindFunction find;
+    };
+
+    // Пути для одного набора символов; AVX2 - только если он есть у процессора.
+    // Последний путь - открытая функция с выбором пути и коротким текстом
+    template <char... Chars>
+    std::vector<Path> MakePaths(FindFunction dispatched) {
+        std::vector<Path> paths{ { "scalar"sv, scan::FindScalar<Chars...> } };
+#if defined(SCAN_X86_DISPATCH) || defined(SCAN_SSE2_ONLY)
+        paths.push_back({ "SSE2"sv, scan::FindSse2<Chars...> });
+#endif
+#ifdef SCAN_X86_DISPATCH
+        if (__builtin_cpu_supports("avx2")) {
+            paths.push_back({ "AVX2"sv, scan::FindAvx2<Chars...> });
+        }
+#endif
+        paths.push_back({ "dispatch"sv, dispatched });
+        return paths;
+    }
+
+    // Просматривает текст от спецсимвола к спецсимволу, как это делают
+    // разбор и экранирование, и возвращает число найденных символов
+    size_t CountSpecials(const std::string& text, FindFunction find) {
+        size_t count = 0;
+        const char* pos = text.data();
+        const char* end = pos + text.size();
+        while ((pos = find(pos, end)) != end) {
+            ++count;
+            ++pos;
+        }
+        return count;
+    }
+
+    void Run(std::string_view name, const std::string& text, const std::vector<Path>& paths) {
+        constexpr int REPEAT = 5;
+        const double megabytes = text.size() / 1e6;
+        const size_t expected = CountSpecials(text, paths.front().find);
+
+        std::cout << name << ", "sv << megabytes << " MB, "sv << expected << " special chars\n"sv;
+        for (const Path& path : paths) {
+            if (CountSpecials(text, path.find) != expected) {
+                std::cerr << path.name << ": wrong number of special chars"sv << std::endl;
+                std::exit(1);
+            }
+            const double ms = bench::MeasureMs(REPEAT, [&] {
+                CountSpecials(text, path.find);
+            });
+            std::cout << "  "sv << path.name << std::string(10 - path.name.size(), ' ')
+                << ms << " ms, "sv << megabytes / ms * 1000 << " MB/s\n"sv;
+        }
+    }
+
+    // Названия длиной около name_length в кавычках, как в base_requests.
+    // Каждое двадцатое содержит '&', который экранируется в SVG
+    std::string MakeStopNames(size_t name_length, size_t total_size) {
+        uint64_t state = 1;
+        auto next = [&state] {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<uint32_t>(state >> 33);
+        };
+
+        std::string text;
+        text.reserve(total_size + name_length + 4);
+        for (size_t stop = 0; text.size() < total_size; ++stop) {
+            text += "\"";
+            const size_t length = name_length / 2 + next() % (name_length + 1);
+            for (size_t i = 0; i < length; ++i) {
+                const uint32_t c = next() % 28;
+                text += c < 26 ? static_cast<char>('a' + c) : ' ';
+            }
+            if (stop % 20 == 0) {
+                text[text.size() - length / 2] = '&';
+            }
+            text += "\", ";
+        }
+        return text;
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t megabytes = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 64;
+    const size_t total_size = megabytes * 1000000;
+
+    const auto json_paths = MakePaths<'"', '\\', '\r', '\n'>(scan::FindJsonSpecial);
+    const auto xml_paths = MakePaths<'&', '<', '>', '\'', '"'>(scan::FindXmlSpecial);
+
+    for (const size_t name_length : { 8, 32, 128, 512 }) {
+        const std::string names = MakeStopNames(name_length, total_size);
+        const std::string title = "stop names ~"s + std::to_string(name_length) + " chars"s;
+        Run(title + ", JSON string"s, names, json_paths);
+        Run(title + ", SVG text"s, names, xml_paths);
+    }
+
+    uint64_t state = 1;
+    std::string svg = bench::MakeSvg(1000, state);
+    const std::string map = svg;
+    while (svg.size() < total_size) {
+        svg += map;
+    }
+    Run("map SVG, JSON string"sv, svg, json_paths);
+}
@@ -0,0 +1,277 @@
+#include "connection_scan_engine.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+namespace catalogue {
+
+	namespace {
+		constexpr double NOT_REACHED = std::numeric_limits<double>::infinity();
+		constexpr uint32_t NO_CONNECTION = std::numeric_limits<uint32_t>::max();
+	}
+
+	ConnectionScanEngine::ConnectionScanEngine(const TransportCatalogue& catalogue,
+		double bus_velocity, double bus_wait_time)
+		: bus_velocity_(bus_velocity)
+		, bus_wait_time_(bus_wait_time) {
+		if (bus_wait_time < 0) {
+			throw std::domain_error("Edges' weights should be non-negative");
+		}
+
+		size_t connection_count = 0;
+		for (BusId bus = 0; bus < catalogue.GetBusCount(); ++bus) {
+			const size_t stop_count = catalogue.GetBusStops(bus).size();
+			if (stop_count >= 2) {
+				connection_count += catalogue.GetBusDepartures(bus).size() * (stop_count - 1);
+			}
+		}
+		if (connection_count >= NO_CONNECTION) {
+			throw std::length_error("too many connections in timetables");
+		}
+		connections_.reserve(connection_count);
+
+		// The same directions the graph is built from: a circular bus goes
+		// through all its stops, a direct one goes through the first half
+		// of them there and back
+		for (BusId bus = 0; bus < catalogue.GetBusCount(); ++bus) {
+			const IdSpan<StopId> stops = catalogue.GetBusStops(bus);
+			if (!catalogue.GetBusDepartures(bus).empty()) {
+				AddConnections(catalogue, bus);
+			}
+			else if (catalogue.GetBusType(bus) == TypeRoute::CIRCLE) {
+				AddPattern(catalogue, bus, stops.begin(), stops.end());
+			}
+			else {
+				const size_t half = (stops.size() + 1) / 2;
+				const std::reverse_iterator<const StopId*> rend(stops.begin());
+				AddPattern(catalogue, bus, stops.begin(), stops.begin() + half);
+				AddPattern(catalogue, bus, rend - half, rend);
+			}
+		}
+		if (pattern_stops_.size() >= NO_CONNECTION || patterns_.size() >= NO_CONNECTION) {
+			throw std::length_error("too many bus stops to route");
+		}
+
+		// A connection of no length comes before the ones leaving when it
+		// arrives; the connections of a trip keep their order
+		std::sort(connections_.begin(), connections_.end(),
+			[](const Connection& lhs, const Connection& rhs) {
+				return std::tie(lhs.departure, lhs.arrival, lhs.trip, lhs.position)
+					< std::tie(rhs.departure, rhs.arrival, rhs.trip, rhs.position);
+			});
+		IndexPatterns(catalogue.GetStopCount());
+
+		arrivals_.assign(catalogue.GetStopCount(), NOT_REACHED);
+		legs_.resize(catalogue.GetStopCount());
+		boardings_.assign(trip_buses_.size(), NO_CONNECTION);
+	}
+
+	void ConnectionScanEngine::AddConnections(const TransportCatalogue& catalogue, BusId bus) {
+		const IdSpan<StopId> stops = catalogue.GetBusStops(bus);
+		if (stops.size() < 2) {
+			return;
+		}
+
+		// Minutes from the first stop, the same for every trip of the bus
+		std::vector<double> offsets(stops.size());
+		uint64_t distance = 0;
+		for (size_t position = 1; position < stops.size(); ++position) {
+			distance += catalogue.GetDistance(stops[position - 1], stops[position]);
+			offsets[position] = double(distance) / bus_velocity_;
+		}
+
+		for (const double departure : catalogue.GetBusDepartures(bus)) {
+			const uint32_t trip = static_cast<uint32_t>(trip_buses_.size());
+			trip_buses_.push_back(bus);
+			for (size_t position = 1; position < stops.size(); ++position) {
+				connections_.push_back(Connection{
+					departure + offsets[position - 1], departure + offsets[position],
+					stops[position - 1], stops[position], trip, static_cast<uint32_t>(position - 1)
+				});
+			}
+		}
+	}
+
+	template <typename Iter>
+	void ConnectionScanEngine::AddPattern(const TransportCatalogue& catalogue, BusId bus, Iter first, Iter last) {
+		if (first == last) {
+			return;
+		}
+		const uint32_t pattern_first = static_cast<uint32_t>(pattern_stops_.size());
+		uint64_t distance = 0;
+		for (Iter it = first; it != last; ++it) {
+			if (it != first) {
+				distance += catalogue.GetDistance(*std::prev(it), *it);
+			}
+			pattern_stops_.push_back(*it);
+			pattern_distances_.push_back(distance);
+		}
+		patterns_.push_back(Pattern{
+			bus, pattern_first, static_cast<uint32_t>(pattern_stops_.size() - pattern_first)
+		});
+	}
+
+	void ConnectionScanEngine::IndexPatterns(size_t stop_count) {
+		stop_offsets_.assign(stop_count + 1, 0);
+		for (const StopId stop : pattern_stops_) {
+			++stop_offsets_[stop + 1];
+		}
+		for (size_t stop = 0; stop < stop_count; ++stop) {
+			stop_offsets_[stop + 1] += stop_offsets_[stop];
+		}
+		stop_patterns_.resize(pattern_stops_.size());
+		std::vector<uint32_t> next(stop_offsets_.begin(), stop_offsets_.end() - 1);
+		for (uint32_t pattern = 0; pattern < patterns_.size(); ++pattern) {
+			for (uint32_t position = 0; position < patterns_[pattern].size; ++position) {
+				const StopId stop = pattern_stops_[patterns_[pattern].first + position];
+				stop_patterns_[next[stop]++] = PatternStop{ pattern, position };
+			}
+		}
+	}
+
+	std::optional<RouteStat> ConnectionScanEngine::BuildRoute(
+		StopId from, StopId to, double departure_time) const {
+		if (from >= arrivals_.size() || to >= arrivals_.size()) {
+			throw std::out_of_range("unknown stop");
+		}
+
+		std::lock_guard lock(mutex_);
+		ResetSearch();
+
+		Arrive(from, departure_time, Leg{ NO_CONNECTION, 0, 0, 0 }, to);
+
+		// Rides on buses without a timetable only set arrivals later than
+		// the stop they start from, so every arrival up to the departure of
+		// a connection is final when the connection is scanned
+		const auto first = std::lower_bound(connections_.begin(), connections_.end(), departure_time,
+			[](const Connection& connection, double time) {
+				return connection.departure < time;
+			});
+		for (auto it = first; it != connections_.end(); ++it) {
+			const Connection& connection = *it;
+			// Nothing leaving later arrives sooner
+			if (arrivals_[to] <= connection.departure) {
+				break;
+			}
+
+			uint32_t& boarding = boardings_[connection.trip];
+			if (boarding == NO_CONNECTION) {
+				if (arrivals_[connection.from] > connection.departure) {
+					continue;
+				}
+				boarding = static_cast<uint32_t>(it - connections_.begin());
+				boarded_trips_.push_back(connection.trip);
+			}
+
+			if (connection.arrival < arrivals_[connection.to]) {
+				const uint32_t index = static_cast<uint32_t>(it - connections_.begin());
+				Arrive(connection.to, connection.arrival, Leg{ index, 0, 0, 0 }, to);
+			}
+		}
+
+		if (arrivals_[to] == NOT_REACHED) {
+			return std::nullopt;
+		}
+		return MakeRoute(from, to);
+	}
+
+	void ConnectionScanEngine::Arrive(StopId stop, double arrival, Leg leg, StopId to) const {
+		if (!(arrival < arrivals_[stop])) {
+			return;
+		}
+		if (arrivals_[stop] == NOT_REACHED) {
+			reached_stops_.push_back(stop);
+		}
+		arrivals_[stop] = arrival;
+		legs_[stop] = leg;
+		if (stop == to || stop_offsets_[stop] == stop_offsets_[stop + 1]) {
+			return;
+		}
+
+		heap_.Push({ arrival, stop });
+		while (!heap_.Empty()) {
+			const HeapItem item = heap_.Top();
+			heap_.Pop();
+			if (item.arrival > arrivals_[item.stop] || item.stop == to) {
+				continue;
+			}
+
+			const double board_weight = item.arrival + bus_wait_time_;
+			for (uint32_t i = stop_offsets_[item.stop]; i < stop_offsets_[item.stop + 1]; ++i) {
+				const PatternStop& pattern_stop = stop_patterns_[i];
+				const Pattern& pattern = patterns_[pattern_stop.pattern];
+				for (uint32_t position = pattern_stop.position + 1; position < pattern.size; ++position) {
+					const double ride_arrival = board_weight
+						+ GetRideWeight(pattern, pattern_stop.position, position);
+					// Farther stops of the pattern are reached no sooner
+					if (ride_arrival >= arrivals_[to]) {
+						break;
+					}
+					const StopId next = pattern_stops_[pattern.first + position];
+					if (ride_arrival < arrivals_[next]) {
+						if (arrivals_[next] == NOT_REACHED) {
+							reached_stops_.push_back(next);
+						}
+						arrivals_[next] = ride_arrival;
+						legs_[next] = Leg{ NO_CONNECTION, pattern_stop.pattern, pattern_stop.position, position };
+						heap_.Push({ ride_arrival, next });
+					}
+				}
+			}
+		}
+	}
+
+	double ConnectionScanEngine::GetRideWeight(const Pattern& pattern, uint32_t board, uint32_t alight) const {
+		const uint64_t distance = pattern_distances_[pattern.first + alight]
+			- pattern_distances_[pattern.first + board];
+		return double(distance) / bus_velocity_;
+	}
+
+	// A stop is reached before the trip it is left by is boarded, and no
+	// connection scanned afterwards arrives there sooner, so the arrivals
+	// met on the way back stay those the trips were boarded with
+	RouteStat ConnectionScanEngine::MakeRoute(StopId from, StopId to) const {
+		RouteStat route;
+		for (StopId stop = to; stop != from;) {
+			const Leg& leg = legs_[stop];
+			if (leg.connection == NO_CONNECTION) {
+				const Pattern& pattern = patterns_[leg.pattern];
+				const StopId board_stop = pattern_stops_[pattern.first + leg.board];
+				route.items.push_back(EdgeBusInfo{
+					pattern.bus, GetRideWeight(pattern, leg.board, leg.alight), leg.alight - leg.board
+				});
+				route.items.push_back(EdgeWaitInfo{ board_stop, bus_wait_time_ });
+				stop = board_stop;
+				continue;
+			}
+
+			const Connection& alight = connections_[leg.connection];
+			const Connection& board = connections_[boardings_[alight.trip]];
+			route.items.push_back(EdgeBusInfo{
+				trip_buses_[alight.trip], alight.arrival - board.departure,
+				alight.position - board.position + 1
+			});
+			route.items.push_back(EdgeWaitInfo{ board.from, board.departure - arrivals_[board.from] });
+			stop = board.from;
+		}
+		std::reverse(route.items.begin(), route.items.end());
+		route.total_time = SumItemWeights(route.items);
+		return route;
+	}
+
+	void ConnectionScanEngine::ResetSearch() const {
+		for (const StopId stop : reached_stops_) {
+			arrivals_[stop] = NOT_REACHED;
+		}
+		reached_stops_.clear();
+		for (const uint32_t trip : boarded_trips_) {
+			boardings_[trip] = NO_CONNECTION;
+		}
+		boarded_trips_.clear();
+	}
+
+} // namespace catalogue
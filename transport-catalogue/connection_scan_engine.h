@@ -0,0 +1,113 @@
+#pragma once
+
+#include "dary_heap.h"
+#include "domain.h"
+#include "transport_catalogue.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace catalogue {
+
+	// Searches the timetables for the route that reaches the last stop
+	// earliest when leaving the first one at a given time (Connection Scan).
+	// Every trip is cut into connections, rides of one bus trip between two
+	// neighbouring stops, which are kept in one array sorted by departure.
+	// A request reads the array once from the first connection leaving after
+	// the given time, so the timetables are searched over contiguous memory
+	// without a heap. A bus without a timetable can be boarded whenever a passenger
+	// comes, after waiting bus_wait_time as in the frequency model: each
+	// time a stop is reached sooner, the rides on such buses from it are
+	// taken at once
+	class ConnectionScanEngine {
+	public:
+		ConnectionScanEngine(const TransportCatalogue& catalogue, double bus_velocity, double bus_wait_time);
+
+		// Waiting for a bus with a timetable is the time until it leaves;
+		// total_time is counted from departure_time to the arrival at the
+		// last stop
+		std::optional<RouteStat> BuildRoute(StopId from, StopId to, double departure_time) const;
+
+	private:
+		struct Connection {
+			double departure;
+			double arrival;
+			StopId from;
+			StopId to;
+			uint32_t trip;
+			// Position of from among the stops of the bus
+			uint32_t position;
+		};
+
+		// The stops a bus without a timetable passes in one direction, as
+		// in RaptorEngine. Its stops and the road distances to them from
+		// the first one are at [first, first + size)
+		struct Pattern {
+			BusId bus;
+			uint32_t first;
+			uint32_t size;
+		};
+
+		struct PatternStop {
+			uint32_t pattern;
+			uint32_t position;
+		};
+
+		// How a stop is reached: by connection, or when it is NO_CONNECTION,
+		// by a ride on the pattern from position board to position alight
+		struct Leg {
+			uint32_t connection;
+			uint32_t pattern;
+			uint32_t board;
+			uint32_t alight;
+		};
+
+		struct HeapItem {
+			double arrival;
+			StopId stop;
+
+			bool operator<(const HeapItem& other) const {
+				return arrival < other.arrival || (arrival == other.arrival && stop < other.stop);
+			}
+		};
+
+		double bus_velocity_;
+		double bus_wait_time_;
+
+		std::vector<Connection> connections_;
+		std::vector<BusId> trip_buses_;
+
+		std::vector<Pattern> patterns_;
+		std::vector<StopId> pattern_stops_;
+		std::vector<uint64_t> pattern_distances_;
+		// The patterns passing stop s are at [stop_offsets_[s], stop_offsets_[s + 1])
+		std::vector<uint32_t> stop_offsets_;
+		std::vector<PatternStop> stop_patterns_;
+
+		// Search state, kept between requests. Only the stops and trips
+		// reached by the previous search are reset
+		mutable std::mutex mutex_;
+		mutable std::vector<double> arrivals_;
+		mutable std::vector<Leg> legs_;
+		mutable std::vector<StopId> reached_stops_;
+		// The connection the trip is boarded at
+		mutable std::vector<uint32_t> boardings_;
+		mutable std::vector<uint32_t> boarded_trips_;
+		mutable DaryHeap<HeapItem> heap_;
+
+		template <typename Iter>
+		void AddPattern(const TransportCatalogue& catalogue, BusId bus, Iter first, Iter last);
+		void AddConnections(const TransportCatalogue& catalogue, BusId bus);
+		void IndexPatterns(size_t stop_count);
+		// Sets the arrival at stop if it is sooner, then rides the buses
+		// without a timetable from every stop reached sooner this way
+		void Arrive(StopId stop, double arrival, Leg leg, StopId to) const;
+		double GetRideWeight(const Pattern& pattern, uint32_t board, uint32_t alight) const;
+		RouteStat MakeRoute(StopId from, StopId to) const;
+		void ResetSearch() const;
+	};
+
+} // namespace catalogue
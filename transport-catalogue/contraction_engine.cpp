@@ -0,0 +1,530 @@
+#include "contraction_engine.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+namespace catalogue {
+
+	namespace {
+		constexpr double NOT_REACHED = std::numeric_limits<double>::infinity();
+		constexpr uint32_t NO_VERTEX = std::numeric_limits<uint32_t>::max();
+
+		// A witness search gives up after settling this many vertices. Giving
+		// up early only adds a shortcut that is not needed, so the priority
+		// of a vertex is estimated with a cheaper search than its contraction
+		constexpr size_t CONTRACT_SETTLE_LIMIT = 500;
+		constexpr size_t PRIORITY_SETTLE_LIMIT = 50;
+	}
+
+	// Keeps the graph that is left after contracting some of the vertices.
+	// Parallel arcs are merged, the lightest one stays
+	class ContractionEngine::Contractor {
+	public:
+		using UpwardArcs = std::vector<std::vector<UpwardArc>>;
+
+		Contractor(const Graph& graph, std::vector<Arc>& arcs);
+
+		// Contracts every vertex and returns its arcs to and from the
+		// vertices contracted after it
+		void Run(UpwardArcs& forward, UpwardArcs& backward);
+
+	private:
+		struct Shortcut {
+			uint32_t from;
+			uint32_t to;
+			double weight;
+			uint32_t first;
+			uint32_t second;
+		};
+
+		std::vector<Arc>& arcs_;
+		std::vector<std::vector<UpwardArc>> out_;
+		std::vector<std::vector<UpwardArc>> in_;
+		std::vector<uint32_t> contracted_neighbours_;
+
+		std::vector<double> witness_weights_;
+		std::vector<uint32_t> witness_reached_;
+		DaryHeap<HeapItem> witness_heap_;
+		// Weights of the arcs from the vertex being contracted to its
+		// out-neighbours, NOT_REACHED for other vertices
+		std::vector<double> target_weights_;
+
+		// Filled by FindShortcuts
+		std::vector<Shortcut> shortcuts_;
+
+		void FindShortcuts(uint32_t vertex, size_t settle_limit);
+		void SearchWitnesses(uint32_t source, double source_weight, uint32_t skipped, size_t settle_limit);
+		int64_t GetPriority(uint32_t vertex);
+		void Contract(uint32_t vertex, UpwardArcs& forward, UpwardArcs& backward);
+		void AddArc(uint32_t from, uint32_t to, double weight, uint32_t arc);
+	};
+
+	ContractionEngine::Contractor::Contractor(const Graph& graph, std::vector<Arc>& arcs)
+		: arcs_(arcs)
+		, out_(graph.GetVertexCount())
+		, in_(graph.GetVertexCount())
+		, contracted_neighbours_(graph.GetVertexCount(), 0)
+		, witness_weights_(graph.GetVertexCount(), NOT_REACHED)
+		, target_weights_(graph.GetVertexCount(), NOT_REACHED) {
+		for (uint32_t from = 0; from < out_.size(); ++from) {
+			std::vector<UpwardArc>& out = out_[from];
+			for (uint32_t position = graph.GetFirstEdge(from); position < graph.GetFirstEdge(from + 1); ++position) {
+				const graph::VertexId to = graph.GetTarget(position);
+				if (to != from) {
+					out.push_back({ static_cast<uint32_t>(to), static_cast<uint32_t>(graph.GetEdgeId(position)),
+						graph.GetWeight(position) });
+				}
+			}
+			// the lightest of the parallel arcs, the first added of equal ones
+			std::sort(out.begin(), out.end(), [](const UpwardArc& l, const UpwardArc& r) {
+				return std::tie(l.vertex, l.weight, l.arc) < std::tie(r.vertex, r.weight, r.arc);
+			});
+			out.erase(std::unique(out.begin(), out.end(), [](const UpwardArc& l, const UpwardArc& r) {
+				return l.vertex == r.vertex;
+			}), out.end());
+
+			for (const UpwardArc& arc : out) {
+				in_[arc.vertex].push_back({ from, arc.arc, arc.weight });
+			}
+		}
+	}
+
+	void ContractionEngine::Contractor::Run(UpwardArcs& forward, UpwardArcs& backward) {
+		const uint32_t vertex_count = static_cast<uint32_t>(out_.size());
+		forward.assign(vertex_count, {});
+		backward.assign(vertex_count, {});
+
+		struct QueueItem {
+			int64_t priority;
+			uint32_t vertex;
+
+			bool operator<(const QueueItem& other) const {
+				return priority < other.priority || (priority == other.priority && vertex < other.vertex);
+			}
+		};
+		DaryHeap<QueueItem> queue;
+		for (uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+			queue.Push({ GetPriority(vertex), vertex });
+		}
+
+		// Priorities of the vertices left change as their neighbours are
+		// contracted; they are brought up to date when a vertex comes out
+		// of the queue
+		while (!queue.Empty()) {
+			const uint32_t vertex = queue.Top().vertex;
+			queue.Pop();
+			const int64_t priority = GetPriority(vertex);
+			if (!queue.Empty() && priority > queue.Top().priority) {
+				queue.Push({ priority, vertex });
+				continue;
+			}
+			Contract(vertex, forward, backward);
+		}
+	}
+
+	// Shortcuts that replace the routes through vertex
+	void ContractionEngine::Contractor::FindShortcuts(uint32_t vertex, size_t settle_limit) {
+		shortcuts_.clear();
+		if (in_[vertex].empty() || out_[vertex].empty()) {
+			return;
+		}
+
+		// A target that can only be entered from vertex has no witness. In
+		// the graph of TransportRouter it is so for the first stop of every
+		// bus direction
+		bool has_witnesses = false;
+		for (const UpwardArc& out : out_[vertex]) {
+			target_weights_[out.vertex] = out.weight;
+			has_witnesses = has_witnesses || in_[out.vertex].size() > 1;
+		}
+
+		for (const UpwardArc& in : in_[vertex]) {
+			if (has_witnesses) {
+				SearchWitnesses(in.vertex, in.weight, vertex, settle_limit);
+			}
+			for (const UpwardArc& out : out_[vertex]) {
+				if (out.vertex == in.vertex) {
+					continue;
+				}
+				const double weight = in.weight + out.weight;
+				if (!has_witnesses || witness_weights_[out.vertex] > weight) {
+					shortcuts_.push_back({ in.vertex, out.vertex, weight, in.arc, out.arc });
+				}
+			}
+		}
+
+		for (const UpwardArc& out : out_[vertex]) {
+			target_weights_[out.vertex] = NOT_REACHED;
+		}
+	}
+
+	// Lightest routes from source that avoid skipped. The search stops once
+	// every target has a route not heavier than the one through skipped,
+	// which source enters with source_weight
+	void ContractionEngine::Contractor::SearchWitnesses(uint32_t source, double source_weight,
+		uint32_t skipped, size_t settle_limit) {
+		for (const uint32_t vertex : witness_reached_) {
+			witness_weights_[vertex] = NOT_REACHED;
+		}
+		witness_reached_.clear();
+		witness_heap_.Clear();
+
+		witness_weights_[source] = 0;
+		witness_reached_.push_back(source);
+		witness_heap_.Push({ 0, source });
+
+		double max_weight = 0;
+		size_t targets_left = 0;
+		for (const UpwardArc& out : out_[skipped]) {
+			if (out.vertex != source) {
+				max_weight = std::max(max_weight, source_weight + out.weight);
+				++targets_left;
+			}
+		}
+
+		size_t settled = 0;
+		while (!witness_heap_.Empty() && settled < settle_limit) {
+			const HeapItem item = witness_heap_.Top();
+			witness_heap_.Pop();
+			if (item.weight > witness_weights_[item.vertex]) {
+				continue;
+			}
+			if (item.weight > max_weight) {
+				break;
+			}
+			++settled;
+
+			for (const UpwardArc& out : out_[item.vertex]) {
+				if (out.vertex == skipped) {
+					continue;
+				}
+				const double weight = item.weight + out.weight;
+				if (weight < witness_weights_[out.vertex]) {
+					const double limit = source_weight + target_weights_[out.vertex];
+					if (out.vertex != source && witness_weights_[out.vertex] > limit && weight <= limit) {
+						--targets_left;
+					}
+					if (witness_weights_[out.vertex] == NOT_REACHED) {
+						witness_reached_.push_back(out.vertex);
+					}
+					witness_weights_[out.vertex] = weight;
+					witness_heap_.Push({ weight, out.vertex });
+				}
+			}
+			if (targets_left == 0) {
+				break;
+			}
+		}
+	}
+
+	// Vertices that add few shortcuts and remove many arcs go first; the
+	// count of contracted neighbours spreads the contraction over the graph
+	int64_t ContractionEngine::Contractor::GetPriority(uint32_t vertex) {
+		FindShortcuts(vertex, PRIORITY_SETTLE_LIMIT);
+		return static_cast<int64_t>(shortcuts_.size())
+			- static_cast<int64_t>(in_[vertex].size() + out_[vertex].size())
+			+ contracted_neighbours_[vertex];
+	}
+
+	void ContractionEngine::Contractor::Contract(uint32_t vertex, UpwardArcs& forward, UpwardArcs& backward) {
+		FindShortcuts(vertex, CONTRACT_SETTLE_LIMIT);
+
+		for (const UpwardArc& in : in_[vertex]) {
+			auto& out = out_[in.vertex];
+			out.erase(std::find_if(out.begin(), out.end(), [vertex](const UpwardArc& arc) {
+				return arc.vertex == vertex;
+			}));
+			++contracted_neighbours_[in.vertex];
+		}
+		for (const UpwardArc& out : out_[vertex]) {
+			auto& in = in_[out.vertex];
+			in.erase(std::find_if(in.begin(), in.end(), [vertex](const UpwardArc& arc) {
+				return arc.vertex == vertex;
+			}));
+			++contracted_neighbours_[out.vertex];
+		}
+		forward[vertex] = std::move(out_[vertex]);
+		backward[vertex] = std::move(in_[vertex]);
+		out_[vertex].clear();
+		in_[vertex].clear();
+
+		for (const Shortcut& shortcut : shortcuts_) {
+			if (arcs_.size() >= NO_ARC) {
+				throw std::length_error("too many shortcuts");
+			}
+			arcs_.push_back({ shortcut.from, shortcut.to, shortcut.first, shortcut.second });
+			AddArc(shortcut.from, shortcut.to, shortcut.weight, static_cast<uint32_t>(arcs_.size() - 1));
+		}
+	}
+
+	void ContractionEngine::Contractor::AddArc(uint32_t from, uint32_t to, double weight, uint32_t arc) {
+		auto& out = out_[from];
+		const auto it = std::find_if(out.begin(), out.end(), [to](const UpwardArc& out_arc) {
+			return out_arc.vertex == to;
+		});
+		if (it == out.end()) {
+			out.push_back({ to, arc, weight });
+			in_[to].push_back({ from, arc, weight });
+			return;
+		}
+		if (weight < it->weight) {
+			*it = { to, arc, weight };
+			auto& in = in_[to];
+			*std::find_if(in.begin(), in.end(), [from](const UpwardArc& in_arc) {
+				return in_arc.vertex == from;
+			}) = { from, arc, weight };
+		}
+	}
+
+	ContractionEngine::ContractionEngine(const Graph& graph)
+		: graph_(graph)
+		, vertex_count_(graph.GetVertexCount()) {
+		if (graph.GetEdgeCount() >= NO_ARC || vertex_count_ >= NO_VERTEX) {
+			throw std::length_error("too large graph for contraction hierarchies");
+		}
+
+		std::vector<Arc> arcs;
+		arcs.reserve(graph.GetEdgeCount());
+		for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+			const auto& edge = graph.GetEdge(edge_id);
+			if (edge.weight < 0) {
+				throw std::domain_error("Edges' weights should be non-negative");
+			}
+			arcs.push_back({ static_cast<uint32_t>(edge.from), static_cast<uint32_t>(edge.to) });
+		}
+
+		Contractor::UpwardArcs forward;
+		Contractor::UpwardArcs backward;
+		Contractor(graph, arcs).Run(forward, backward);
+		arcs_ = snapshot::Array<Arc>(std::move(arcs));
+
+		auto flatten = [](Contractor::UpwardArcs& upward, snapshot::Array<uint32_t>& offsets,
+			snapshot::Array<UpwardArc>& arcs) {
+			std::vector<uint32_t> flat_offsets;
+			std::vector<UpwardArc> flat_arcs;
+			flat_offsets.reserve(upward.size() + 1);
+			flat_offsets.push_back(0);
+			for (auto& vertex_arcs : upward) {
+				flat_arcs.insert(flat_arcs.end(), vertex_arcs.begin(), vertex_arcs.end());
+				flat_offsets.push_back(static_cast<uint32_t>(flat_arcs.size()));
+				std::vector<UpwardArc>().swap(vertex_arcs);
+			}
+			offsets = snapshot::Array<uint32_t>(std::move(flat_offsets));
+			arcs = snapshot::Array<UpwardArc>(std::move(flat_arcs));
+		};
+		flatten(forward, forward_offsets_, forward_arcs_);
+		flatten(backward, backward_offsets_, backward_arcs_);
+		PrepareSearches();
+	}
+
+	ContractionEngine::ContractionEngine(const Graph& graph, snapshot::Reader& reader)
+		: graph_(graph)
+		, vertex_count_(graph.GetVertexCount()) {
+		reader.Read(arcs_);
+		reader.Read(forward_offsets_);
+		reader.Read(forward_arcs_);
+		reader.Read(backward_offsets_);
+		reader.Read(backward_arcs_);
+
+		const size_t edge_count = graph.GetEdgeCount();
+		if (arcs_.size() < edge_count || arcs_.size() >= NO_ARC) {
+			throw snapshot::SnapshotError("wrong contraction hierarchy in snapshot");
+		}
+		// A shortcut weighs as much as its two halves, added as in Contract
+		std::vector<double> arc_weights(arcs_.size());
+		for (uint32_t arc_id = 0; arc_id < arcs_.size(); ++arc_id) {
+			const Arc& arc = arcs_[arc_id];
+			// a shortcut is made of arcs added before it, so unpacking ends
+			const bool is_valid = arc_id < edge_count
+				? arc.from == graph.GetEdge(arc_id).from && arc.to == graph.GetEdge(arc_id).to
+					&& arc.first == NO_ARC && arc.second == NO_ARC
+				: arc.first < arc_id && arc.second < arc_id
+					&& arcs_[arc.first].from == arc.from && arcs_[arc.first].to == arcs_[arc.second].from
+					&& arcs_[arc.second].to == arc.to;
+			if (!is_valid) {
+				throw snapshot::SnapshotError("wrong contraction hierarchy in snapshot");
+			}
+			arc_weights[arc_id] = arc_id < edge_count
+				? graph.GetEdge(arc_id).weight
+				: arc_weights[arc.first] + arc_weights[arc.second];
+		}
+
+		// An upward arc has to name an arc between its two vertices and
+		// carry that arc's weight, otherwise the search finds wrong routes
+		auto check_upward = [this, &arc_weights](const snapshot::Array<uint32_t>& offsets,
+			const snapshot::Array<UpwardArc>& arcs, bool is_forward) {
+			if (offsets.size() != vertex_count_ + 1 || offsets.front() != 0 || offsets.back() != arcs.size()
+				|| !std::is_sorted(offsets.begin(), offsets.end())) {
+				throw snapshot::SnapshotError("wrong contraction hierarchy in snapshot");
+			}
+			for (uint32_t vertex = 0; vertex < vertex_count_; ++vertex) {
+				for (uint32_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+					const UpwardArc& upward = arcs[i];
+					if (upward.vertex >= vertex_count_ || upward.arc >= arcs_.size()
+						|| upward.weight != arc_weights[upward.arc]) {
+						throw snapshot::SnapshotError("wrong contraction hierarchy in snapshot");
+					}
+					const Arc& arc = arcs_[upward.arc];
+					const bool is_valid = is_forward
+						? arc.from == vertex && arc.to == upward.vertex
+						: arc.to == vertex && arc.from == upward.vertex;
+					if (!is_valid) {
+						throw snapshot::SnapshotError("wrong contraction hierarchy in snapshot");
+					}
+				}
+			}
+		};
+		check_upward(forward_offsets_, forward_arcs_, true);
+		check_upward(backward_offsets_, backward_arcs_, false);
+		PrepareSearches();
+	}
+
+	void ContractionEngine::PrepareSearches() {
+		for (Search* search : { &forward_search_, &backward_search_ }) {
+			search->weights.assign(vertex_count_, NOT_REACHED);
+			search->prev_arcs.assign(vertex_count_, NO_ARC);
+		}
+	}
+
+	void ContractionEngine::Search::Reset() {
+		for (const uint32_t vertex : reached) {
+			weights[vertex] = NOT_REACHED;
+			prev_arcs[vertex] = NO_ARC;
+		}
+		reached.clear();
+		heap.Clear();
+	}
+
+	void ContractionEngine::Search::Reach(uint32_t vertex, double weight, uint32_t arc) {
+		if (weights[vertex] == NOT_REACHED) {
+			reached.push_back(vertex);
+		}
+		weights[vertex] = weight;
+		prev_arcs[vertex] = arc;
+		heap.Push({ weight, vertex });
+	}
+
+	std::optional<ContractionEngine::RouteInfo> ContractionEngine::BuildRoute(
+		graph::VertexId from, graph::VertexId to) const {
+		if (from >= vertex_count_ || to >= vertex_count_) {
+			throw std::out_of_range("unknown vertex");
+		}
+
+		std::lock_guard lock(mutex_);
+		Search& forward = forward_search_;
+		Search& backward = backward_search_;
+		forward.Reset();
+		backward.Reset();
+		settled_count_ = 0;
+		forward.Reach(static_cast<uint32_t>(from), 0, NO_ARC);
+		backward.Reach(static_cast<uint32_t>(to), 0, NO_ARC);
+
+		double best_weight = NOT_REACHED;
+		uint32_t meeting_vertex = NO_VERTEX;
+
+		// A direction stops once its lightest vertex is not lighter than
+		// the best route found; the searches take turns by the lighter top
+		while (true) {
+			const bool forward_goes = !forward.heap.Empty() && forward.heap.Top().weight < best_weight;
+			const bool backward_goes = !backward.heap.Empty() && backward.heap.Top().weight < best_weight;
+			if (!forward_goes && !backward_goes) {
+				break;
+			}
+			const bool is_forward = forward_goes
+				&& (!backward_goes || !(backward.heap.Top() < forward.heap.Top()));
+			Search& search = is_forward ? forward : backward;
+			const Search& other = is_forward ? backward : forward;
+			const snapshot::Array<uint32_t>& offsets = is_forward ? forward_offsets_ : backward_offsets_;
+			const snapshot::Array<UpwardArc>& arcs = is_forward ? forward_arcs_ : backward_arcs_;
+			const snapshot::Array<uint32_t>& stall_offsets = is_forward ? backward_offsets_ : forward_offsets_;
+			const snapshot::Array<UpwardArc>& stall_arcs = is_forward ? backward_arcs_ : forward_arcs_;
+
+			const HeapItem item = search.heap.Top();
+			search.heap.Pop();
+			if (item.weight > search.weights[item.vertex]) {
+				continue;
+			}
+			++settled_count_;
+			if (const double weight = item.weight + other.weights[item.vertex]; weight < best_weight) {
+				best_weight = weight;
+				meeting_vertex = item.vertex;
+			}
+
+			// Stall-on-demand: a vertex reached lighter from a higher vertex
+			// is not on a shortest upward route, so its arcs are not relaxed
+			bool is_stalled = false;
+			for (size_t i = stall_offsets[item.vertex]; i < stall_offsets[item.vertex + 1] && !is_stalled; ++i) {
+				is_stalled = search.weights[stall_arcs[i].vertex] + stall_arcs[i].weight < item.weight;
+			}
+			if (is_stalled) {
+				continue;
+			}
+
+			for (size_t i = offsets[item.vertex]; i < offsets[item.vertex + 1]; ++i) {
+				const UpwardArc& arc = arcs[i];
+				const double weight = item.weight + arc.weight;
+				if (weight < search.weights[arc.vertex]) {
+					search.Reach(arc.vertex, weight, arc.arc);
+				}
+			}
+		}
+
+		if (meeting_vertex == NO_VERTEX) {
+			return std::nullopt;
+		}
+
+		std::vector<uint32_t> forward_arcs;
+		for (uint32_t vertex = meeting_vertex; forward.prev_arcs[vertex] != NO_ARC;
+			vertex = arcs_[forward.prev_arcs[vertex]].from) {
+			forward_arcs.push_back(forward.prev_arcs[vertex]);
+		}
+
+		std::vector<graph::EdgeId> edges;
+		for (auto it = forward_arcs.rbegin(); it != forward_arcs.rend(); ++it) {
+			UnpackArc(*it, edges);
+		}
+		for (uint32_t vertex = meeting_vertex; backward.prev_arcs[vertex] != NO_ARC;
+			vertex = arcs_[backward.prev_arcs[vertex]].to) {
+			UnpackArc(backward.prev_arcs[vertex], edges);
+		}
+
+		return RouteInfo{ best_weight, std::move(edges) };
+	}
+
+	size_t ContractionEngine::GetSettledCount() const {
+		std::lock_guard lock(mutex_);
+		return settled_count_;
+	}
+
+	size_t ContractionEngine::GetShortcutCount() const {
+		return arcs_.size() - graph_.GetEdgeCount();
+	}
+
+	void ContractionEngine::Save(snapshot::Writer& writer) const {
+		writer.Write(arcs_);
+		writer.Write(forward_offsets_);
+		writer.Write(forward_arcs_);
+		writer.Write(backward_offsets_);
+		writer.Write(backward_arcs_);
+	}
+
+	void ContractionEngine::UnpackArc(uint32_t arc, std::vector<graph::EdgeId>& edges) const {
+		std::vector<uint32_t> stack = { arc };
+		while (!stack.empty()) {
+			const Arc& top = arcs_[stack.back()];
+			const uint32_t top_id = stack.back();
+			stack.pop_back();
+			if (top.first == NO_ARC) {
+				edges.push_back(top_id);
+			}
+			else {
+				stack.push_back(top.second);
+				stack.push_back(top.first);
+			}
+		}
+	}
+
+} // namespace catalogue
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "dary_heap.h"
+#include "route_engine.h"
+#include "snapshot.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace catalogue {
+
+	// Contraction hierarchies. Vertices are contracted one by one, from the
+	// least important; a shortcut replaces every route through the
+	// contracted vertex that may be the only shortest one. A request then
+	// searches from both ends, going only to vertices contracted later, and
+	// the shortcuts of the route found are unpacked back into edges of the
+	// graph. The graph has to outlive the engine
+	class ContractionEngine final : public RouteEngine {
+	public:
+		explicit ContractionEngine(const Graph& graph);
+		// Loads the hierarchy saved for graph. Throws snapshot::SnapshotError
+		// if it does not fit the graph
+		ContractionEngine(const Graph& graph, snapshot::Reader& reader);
+
+		std::optional<RouteInfo> BuildRoute(graph::VertexId from, graph::VertexId to) const override;
+		// In both directions of the search
+		size_t GetSettledCount() const override;
+
+		size_t GetShortcutCount() const;
+
+		void Save(snapshot::Writer& writer) const;
+
+	private:
+		static constexpr uint32_t NO_ARC = UINT32_MAX;
+
+		// Arc i < graph edge count is edge i of the graph, the rest are
+		// shortcuts made of two arcs each
+		struct Arc {
+			uint32_t from;
+			uint32_t to;
+			uint32_t first = NO_ARC;
+			uint32_t second = NO_ARC;
+		};
+
+		// Arcs to vertices contracted later. For the backward search the
+		// arcs into a vertex are stored at that vertex, with from in vertex
+		struct UpwardArc {
+			uint32_t vertex;
+			uint32_t arc;
+			double weight;
+		};
+
+		struct HeapItem {
+			double weight;
+			uint32_t vertex;
+
+			bool operator<(const HeapItem& other) const {
+				return weight < other.weight || (weight == other.weight && vertex < other.vertex);
+			}
+		};
+
+		// One direction of the search, kept between requests
+		struct Search {
+			std::vector<double> weights;
+			std::vector<uint32_t> prev_arcs;
+			std::vector<uint32_t> reached;
+			DaryHeap<HeapItem> heap;
+
+			void Reset();
+			void Reach(uint32_t vertex, double weight, uint32_t arc);
+		};
+
+		const Graph& graph_;
+		size_t vertex_count_;
+		// A loaded hierarchy is read straight from the mapped file
+		snapshot::Array<Arc> arcs_;
+		// Upward arcs of vertex v are arcs[offsets[v] .. offsets[v + 1])
+		snapshot::Array<uint32_t> forward_offsets_;
+		snapshot::Array<UpwardArc> forward_arcs_;
+		snapshot::Array<uint32_t> backward_offsets_;
+		snapshot::Array<UpwardArc> backward_arcs_;
+
+		mutable std::mutex mutex_;
+		mutable Search forward_search_;
+		mutable Search backward_search_;
+		mutable size_t settled_count_ = 0;
+
+		class Contractor;
+
+		void PrepareSearches();
+		void UnpackArc(uint32_t arc, std::vector<graph::EdgeId>& edges) const;
+	};
+
+} // namespace catalogue
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace catalogue {
+
+	// Min-heap where every node has D children. It is shallower than a binary
+	// heap, so Push does fewer moves, and the children compared by Pop lie
+	// next to each other in memory
+	template <typename T, size_t D = 4, typename Compare = std::less<T>>
+	class DaryHeap {
+	public:
+		bool Empty() const {
+			return items_.empty();
+		}
+
+		size_t Size() const {
+			return items_.size();
+		}
+
+		const T& Top() const {
+			return items_.front();
+		}
+
+		void Push(T value) {
+			size_t index = items_.size();
+			items_.push_back(std::move(value));
+			while (index > 0) {
+				const size_t parent = (index - 1) / D;
+				if (!compare_(items_[index], items_[parent])) {
+					break;
+				}
+				std::swap(items_[index], items_[parent]);
+				index = parent;
+			}
+		}
+
+		void Pop() {
+			items_.front() = std::move(items_.back());
+			items_.pop_back();
+
+			size_t index = 0;
+			while (true) {
+				const size_t first_child = index * D + 1;
+				if (first_child >= items_.size()) {
+					break;
+				}
+				const size_t last_child = std::min(first_child + D, items_.size());
+				size_t smallest = first_child;
+				for (size_t child = first_child + 1; child < last_child; ++child) {
+					if (compare_(items_[child], items_[smallest])) {
+						smallest = child;
+					}
+				}
+				if (!compare_(items_[smallest], items_[index])) {
+					break;
+				}
+				std::swap(items_[index], items_[smallest]);
+				index = smallest;
+			}
+		}
+
+		void Clear() {
+			items_.clear();
+		}
+
+	private:
+		std::vector<T> items_;
+		Compare compare_;
+	};
+
+} // namespace catalogue
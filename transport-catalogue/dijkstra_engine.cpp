@@ -0,0 +1,108 @@
+#include "dijkstra_engine.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace catalogue {
+
+	namespace {
+		constexpr double NOT_REACHED = std::numeric_limits<double>::infinity();
+		constexpr graph::EdgeId NO_EDGE = std::numeric_limits<graph::EdgeId>::max();
+	}
+
+	DijkstraEngine::DijkstraEngine(const Graph& graph, size_t cache_size)
+		: graph_(graph)
+		, cache_(cache_size)
+		, weights_(graph.GetVertexCount(), NOT_REACHED)
+		, prev_edges_(graph.GetVertexCount(), NO_EDGE) {
+		for (uint32_t position = 0; position < graph.GetEdgeCount(); ++position) {
+			if (graph.GetWeight(position) < 0) {
+				throw std::domain_error("Edges' weights should be non-negative");
+			}
+		}
+	}
+
+	std::optional<DijkstraEngine::RouteInfo> DijkstraEngine::BuildRoute(
+		graph::VertexId from, graph::VertexId to) const {
+		if (from >= weights_.size() || to >= weights_.size()) {
+			throw std::out_of_range("unknown vertex");
+		}
+
+		const uint64_t key = (static_cast<uint64_t>(from) << 32) | static_cast<uint32_t>(to);
+		std::lock_guard lock(mutex_);
+		if (const auto* route = cache_.Find(key)) {
+			settled_count_ = 0;
+			return *route;
+		}
+
+		std::optional<RouteInfo> route = Search(from, to);
+		cache_.Insert(key, route);
+		return route;
+	}
+
+	std::optional<DijkstraEngine::RouteInfo> DijkstraEngine::Search(
+		graph::VertexId from, graph::VertexId to) const {
+		ResetSearch();
+
+		weights_[from] = 0;
+		reached_.push_back(from);
+		heap_.Push({ 0, from });
+
+		while (!heap_.Empty()) {
+			const HeapItem item = heap_.Top();
+			heap_.Pop();
+			// a vertex may be in the heap several times; only the best entry counts
+			if (item.weight > weights_[item.vertex]) {
+				continue;
+			}
+			++settled_count_;
+			if (item.vertex == to) {
+				break;
+			}
+
+			const uint32_t end = graph_.GetFirstEdge(item.vertex + 1);
+			for (uint32_t position = graph_.GetFirstEdge(item.vertex); position < end; ++position) {
+				const graph::VertexId next = graph_.GetTarget(position);
+				const double weight = item.weight + graph_.GetWeight(position);
+				if (weight < weights_[next]) {
+					if (weights_[next] == NOT_REACHED) {
+						reached_.push_back(next);
+					}
+					weights_[next] = weight;
+					prev_edges_[next] = graph_.GetEdgeId(position);
+					heap_.Push({ weight, next });
+				}
+			}
+		}
+
+		if (weights_[to] == NOT_REACHED) {
+			return std::nullopt;
+		}
+
+		std::vector<graph::EdgeId> edges;
+		for (graph::VertexId vertex = to; vertex != from; vertex = graph_.GetEdgeFrom(edges.back())) {
+			edges.push_back(prev_edges_[vertex]);
+		}
+		std::reverse(edges.begin(), edges.end());
+
+		return RouteInfo{ weights_[to], std::move(edges) };
+	}
+
+	size_t DijkstraEngine::GetSettledCount() const {
+		std::lock_guard lock(mutex_);
+		return settled_count_;
+	}
+
+	void DijkstraEngine::ResetSearch() const {
+		for (const graph::VertexId vertex : reached_) {
+			weights_[vertex] = NOT_REACHED;
+			prev_edges_[vertex] = NO_EDGE;
+		}
+		reached_.clear();
+		heap_.Clear();
+		settled_count_ = 0;
+	}
+
+} // namespace catalogue
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "dary_heap.h"
+#include "lru_cache.h"
+#include "route_engine.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace catalogue {
+
+	// Nothing is prepared in advance: every request runs Dijkstra's search
+	// from its first stop until the last one is reached. Memory is linear in
+	// the size of the graph. Recent answers are kept in an LRU cache
+	class DijkstraEngine final : public RouteEngine {
+	public:
+		DijkstraEngine(const Graph& graph, size_t cache_size);
+
+		std::optional<RouteInfo> BuildRoute(graph::VertexId from, graph::VertexId to) const override;
+		size_t GetSettledCount() const override;
+
+	private:
+		struct HeapItem {
+			double weight;
+			graph::VertexId vertex;
+
+			bool operator<(const HeapItem& other) const {
+				return weight < other.weight || (weight == other.weight && vertex < other.vertex);
+			}
+		};
+
+		const Graph& graph_;
+
+		// Requests may come from several threads; the search state and the
+		// cache are shared
+		mutable std::mutex mutex_;
+		mutable LruCache<uint64_t, std::optional<RouteInfo>> cache_;
+		// Search state, kept between requests. Only the vertices reached by
+		// the previous search are reset
+		mutable std::vector<double> weights_;
+		mutable std::vector<graph::EdgeId> prev_edges_;
+		mutable std::vector<graph::VertexId> reached_;
+		mutable DaryHeap<HeapItem> heap_;
+		mutable size_t settled_count_ = 0;
+
+		std::optional<RouteInfo> Search(graph::VertexId from, graph::VertexId to) const;
+		void ResetSearch() const;
+	};
+
+} // namespace catalogue
@@ -2,29 +2,62 @@
 
 #include "geo.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <string_view>
-#include <set>
-#include <unordered_set>
-#include <deque>
-#include <optional>
+#include <variant>
+#include <vector>
 
 namespace catalogue {
 
+	// Stops and buses are numbered densely in the order they are added
+	using StopId = uint32_t;
+	using BusId = uint32_t;
+
 	enum class TypeRoute {
 		CIRCLE,
 		DIRECT
 	};
 
+	// Names are views; TransportCatalogue keeps the memory they refer to alive
 	struct Stop {
-		std::string name;
+		std::string_view name;
 		geo::Coordinates coordinate;
 	};
 
+	// For a direct route stops hold the whole way there and back.
+	// departures are the minutes from the start of the day at which trips
+	// leave the first stop, in ascending order; a trip goes all the stops
+	// without a break. A bus without departures runs by the frequency
+	// model of RoutingSettings
 	struct Bus {
 		TypeRoute type_route;
-		std::string name;
-		std::deque<const Stop*> stops;
+		std::string_view name;
+		std::vector<StopId> stops;
+		std::vector<double> departures;
+	};
+
+	// A contiguous range of ids, or other values, inside the catalogue storage
+	template <typename Id>
+	class IdSpan {
+	public:
+		IdSpan() = default;
+		IdSpan(const Id* begin, const Id* end)
+			: begin_(begin), end_(end) {
+		}
+
+		const Id* begin() const { return begin_; }
+		const Id* end() const { return end_; }
+		size_t size() const { return static_cast<size_t>(end_ - begin_); }
+		bool empty() const { return begin_ == end_; }
+		const Id& operator[](size_t index) const { return begin_[index]; }
+		const Id& front() const { return *begin_; }
+		const Id& back() const { return *(end_ - 1); }
+
+	private:
+		const Id* begin_ = nullptr;
+		const Id* end_ = nullptr;
 	};
 
 	struct BusInfo {
@@ -36,20 +69,42 @@ namespace catalogue {
 		double curvature = 0;
 	};
 
+	// buses is a view into the catalogue, sorted by bus name
 	struct StopInfo {
 		bool to_exist = false;
-		std::string name = "unknown stop";
-		std::unordered_set<const Bus*> buses;
+		std::string_view name = "unknown stop";
+		IdSpan<BusId> buses;
 	};
 
-	struct CompareBuses {
-	public:
-		bool operator()(const Bus* l, const Bus* r) const;
+	// Items of a route: waiting for a bus at a stop and riding a bus
+	struct EdgeWaitInfo {
+		StopId stop = 0;
+		double weight = 0;
 	};
 
-	struct CompareStop {
-	public:
-		bool operator()(const Stop* l, const Stop* r) const;
+	struct EdgeBusInfo {
+		BusId bus = 0;
+		double weight = 0;
+		size_t span_count = 0;
+	};
+
+	using EdgeInfo = std::variant<EdgeWaitInfo, EdgeBusInfo>;
+
+	// items are in the order they are passed; their weights add up to total_time
+	struct RouteStat {
+		double total_time = 0;
+		std::vector<EdgeInfo> items;
 	};
 
+	// Adds the weights up from the first item to the last. Engines sum the
+	// weights in different orders while searching, and the last digit of
+	// the sum depends on the order, so every engine takes total_time from here
+	inline double SumItemWeights(const std::vector<EdgeInfo>& items) {
+		double total = 0;
+		for (const EdgeInfo& item : items) {
+			total += std::visit([](const auto& info) { return info.weight; }, item);
+		}
+		return total;
+	}
+
 } // namespace catalogue
@@ -0,0 +1,42 @@
+#include "frozen_graph.h"
+
+#include <limits>
+#include <stdexcept>
+
+namespace catalogue {
+
+	FrozenGraph::FrozenGraph(const Graph& graph) {
+		const size_t vertex_count = graph.GetVertexCount();
+		const size_t edge_count = graph.GetEdgeCount();
+		if (vertex_count >= std::numeric_limits<uint32_t>::max()
+			|| edge_count >= std::numeric_limits<uint32_t>::max()) {
+			throw std::length_error("too large graph to freeze");
+		}
+
+		offsets_.reserve(vertex_count + 1);
+		targets_.reserve(edge_count);
+		weights_.reserve(edge_count);
+		edge_ids_.reserve(edge_count);
+		sources_.resize(edge_count);
+		positions_.resize(edge_count);
+
+		offsets_.push_back(0);
+		for (graph::VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+			for (const graph::EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+				const auto& edge = graph.GetEdge(edge_id);
+				sources_[edge_id] = static_cast<uint32_t>(vertex);
+				positions_[edge_id] = static_cast<uint32_t>(targets_.size());
+				targets_.push_back(static_cast<uint32_t>(edge.to));
+				weights_.push_back(edge.weight);
+				edge_ids_.push_back(static_cast<uint32_t>(edge_id));
+			}
+			offsets_.push_back(static_cast<uint32_t>(targets_.size()));
+		}
+	}
+
+	graph::Edge<double> FrozenGraph::GetEdge(graph::EdgeId edge_id) const {
+		const uint32_t position = positions_.at(edge_id);
+		return graph::Edge<double>{ sources_[edge_id], targets_[position], weights_[position] };
+	}
+
+} // namespace catalogue
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "graph.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace catalogue {
+
+	// Read-only copy of a built graph in compressed sparse rows. The edges
+	// leaving vertex v take positions [GetFirstEdge(v), GetFirstEdge(v + 1))
+	// of contiguous arrays, in the order the graph lists them; targets and
+	// weights are separate arrays, so a search reads only what it needs.
+	// Edge ids stay those of the original graph
+	class FrozenGraph {
+	public:
+		using Graph = graph::DirectedWeightedGraph<double>;
+
+		explicit FrozenGraph(const Graph& graph);
+
+		size_t GetVertexCount() const {
+			return offsets_.size() - 1;
+		}
+
+		size_t GetEdgeCount() const {
+			return targets_.size();
+		}
+
+		uint32_t GetFirstEdge(graph::VertexId vertex) const {
+			return offsets_[vertex];
+		}
+
+		// By position of the edge
+		graph::VertexId GetTarget(uint32_t position) const {
+			return targets_[position];
+		}
+
+		double GetWeight(uint32_t position) const {
+			return weights_[position];
+		}
+
+		graph::EdgeId GetEdgeId(uint32_t position) const {
+			return edge_ids_[position];
+		}
+
+		// By id of the edge
+		graph::VertexId GetEdgeFrom(graph::EdgeId edge_id) const {
+			return sources_[edge_id];
+		}
+
+		graph::Edge<double> GetEdge(graph::EdgeId edge_id) const;
+
+	private:
+		std::vector<uint32_t> offsets_;
+		std::vector<uint32_t> targets_;
+		std::vector<double> weights_;
+		std::vector<uint32_t> edge_ids_;
+		// Indexed by edge id
+		std::vector<uint32_t> sources_;
+		std::vector<uint32_t> positions_;
+	};
+
+} // namespace catalogue
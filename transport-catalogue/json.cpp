@@ -1,362 +1,526 @@
 #include "json.h"
+#include "simd_scan.h"
 
+#include <algorithm>
+#include <charconv>
 #include <iterator>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
 
 namespace json {
 
     namespace {
         using namespace std::literals;
 
-        Node LoadNode(std::istream& input);
-        Node LoadString(std::istream& input);
+        bool IsSpace(char c) {
+            return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+        }
 
-        std::string LoadLiteral(std::istream& input) {
-            std::string s;
-            while (std::isalpha(input.peek())) {
-                s.push_back(static_cast<char>(input.get()));
-            }
-            return s;
+        bool IsDigit(char c) {
+            return c >= '0' && c <= '9';
         }
 
-        Node LoadArray(std::istream& input) {
-            std::vector<Node> result;
+        bool IsAlpha(char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+        }
 
-            for (char c; input >> c && c != ']';) {
-                if (c != ',') {
-                    input.putback(c);
+        // Источник для Parser: текст, целиком лежащий в памяти.
+        // Отдаётся одним блоком
+        class WholeInput {
+        public:
+            explicit WholeInput(std::string_view input)
+                : input_(input) {
+            }
+
+            bool Refill(const char*& pos, const char*& end, const char*& /*mark*/) {
+                if (done_) {
+                    return false;
                 }
-                result.push_back(LoadNode(input));
+                done_ = true;
+                pos = input_.data();
+                end = input_.data() + input_.size();
+                return !input_.empty();
             }
-            if (!input) {
-                throw ParsingError("Array parsing error"s);
+
+        private:
+            std::string_view input_;
+            bool done_ = false;
+        };
+
+        // Источник для Parser: поток, читаемый блоками фиксированного размера.
+        // Начатая лексема (от mark) переносится в начало буфера, поэтому
+        // буфер растёт только ради лексем длиннее блока
+        class ChunkedInput {
+        public:
+            explicit ChunkedInput(std::istream& input)
+                : input_(input) {
             }
-            return Node(std::move(result));
-        }
 
-        Node LoadDict(std::istream& input) {
-            Dict dict;
+            bool Refill(const char*& pos, const char*& end, const char*& mark) {
+                const char* data = buffer_.data();
+                const size_t keep_from = static_cast<size_t>((mark ? mark : pos) - data);
+                const size_t kept = static_cast<size_t>(end - data) - keep_from;
+                const size_t pos_offset = static_cast<size_t>(pos - data) - keep_from;
+                const size_t mark_offset = mark ? static_cast<size_t>(mark - data) - keep_from : 0;
 
-            for (char c; input >> c && c != '}';) {
-                if (c == '"') {
-                    std::string key = LoadString(input).AsString();
-                    if (input >> c && c == ':') {
-                        if (dict.find(key) != dict.end()) {
-                            throw ParsingError("Duplicate key '"s + key + "' have been found");
-                        }
-                        dict.emplace(std::move(key), LoadNode(input));
-                    }
-                    else {
-                        throw ParsingError(": is expected but '"s + c + "' has been found"s);
-                    }
+                if (keep_from > 0) {
+                    std::copy(buffer_.begin() + keep_from, buffer_.begin() + keep_from + kept, buffer_.begin());
                 }
-                else if (c != ',') {
-                    throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+                if (buffer_.size() < kept + CHUNK_SIZE) {
+                    buffer_.resize(kept + CHUNK_SIZE);
                 }
+                input_.read(buffer_.data() + kept, CHUNK_SIZE);
+                const auto read = static_cast<size_t>(input_.gcount());
+
+                data = buffer_.data();
+                pos = data + pos_offset;
+                end = data + kept + read;
+                if (mark) {
+                    mark = data + mark_offset;
+                }
+                return read > 0;
             }
-            if (!input) {
-                throw ParsingError("Dictionary parsing error"s);
+
+        private:
+            static constexpr size_t CHUNK_SIZE = 1 << 16;
+
+            std::istream& input_;
+            std::vector<char> buffer_;
+        };
+
+        // Разбирает JSON и сообщает о найденных значениях обработчику.
+        // Текст берётся у Source блоками и просматривается указателем,
+        // без посимвольного чтения из потока
+        template <typename EventHandler, typename Source>
+        class Parser {
+        public:
+            Parser(Source& source, EventHandler& handler)
+                : source_(source)
+                , handler_(handler) {
             }
-            return Node(std::move(dict));
-        }
 
-        Node LoadString(std::istream& input) {
-            auto it = std::istreambuf_iterator<char>(input);
-            auto end = std::istreambuf_iterator<char>();
-            std::string s;
-            while (true) {
-                if (it == end) {
-                    throw ParsingError("String parsing error");
+            void ParseNode() {
+                if (!SkipSpaces()) {
+                    throw ParsingError("Unexpected EOF"s);
                 }
-                const char ch = *it;
-                if (ch == '"') {
-                    ++it;
+                switch (*pos_) {
+                case '[':
+                    ++pos_;
+                    ParseArray();
+                    break;
+                case '{':
+                    ++pos_;
+                    ParseDict();
                     break;
+                case '"':
+                    ++pos_;
+                    handler_.String(ParseString());
+                    break;
+                case 't':
+                    [[fallthrough]];
+                case 'f':
+                    ParseBool();
+                    break;
+                case 'n':
+                    ParseNull();
+                    break;
+                default:
+                    ParseNumber();
+                    break;
+                }
+            }
+
+        private:
+            Source& source_;
+            const char* pos_ = nullptr;
+            const char* end_ = nullptr;
+            // Начало разбираемой лексемы. Source сохраняет текст начиная с него
+            const char* mark_ = nullptr;
+            EventHandler& handler_;
+            // Строки с экранированием собираются здесь
+            std::string unescaped_;
+
+            // Возвращает false, если текст закончился
+            bool HasMore() {
+                return pos_ != end_ || source_.Refill(pos_, end_, mark_);
+            }
+
+            // Пропускает пробельные символы. Возвращает false, если текст закончился
+            bool SkipSpaces() {
+                mark_ = nullptr;
+                while (HasMore() && IsSpace(*pos_)) {
+                    ++pos_;
+                }
+                return HasMore();
+            }
+
+            void ParseArray() {
+                handler_.StartArray();
+                while (SkipSpaces() && *pos_ != ']') {
+                    if (*pos_ == ',') {
+                        ++pos_;
+                    }
+                    ParseNode();
+                }
+                if (!HasMore()) {
+                    throw ParsingError("Array parsing error"s);
+                }
+                ++pos_;
+                handler_.EndArray();
+            }
+
+            void ParseDict() {
+                handler_.StartDict();
+                while (SkipSpaces() && *pos_ != '}') {
+                    const char c = *pos_++;
+                    if (c == '"') {
+                        handler_.Key(ParseString());
+                        if (SkipSpaces() && *pos_ == ':') {
+                            ++pos_;
+                            ParseNode();
+                        }
+                        else {
+                            throw ParsingError(": is expected but '"s
+                                + (!HasMore() ? ""s : std::string(1, *pos_)) + "' has been found"s);
+                        }
+                    }
+                    else if (c != ',') {
+                        throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+                    }
+                }
+                if (!HasMore()) {
+                    throw ParsingError("Dictionary parsing error"s);
                 }
-                else if (ch == '\\') {
-                    ++it;
-                    if (it == end) {
+                ++pos_;
+                handler_.EndDict();
+            }
+
+            // Вызывается после открывающей кавычки. Строка без экранирования
+            // возвращается как ссылка на входной буфер, остальные собираются
+            // в unescaped_ участками без экранирования. mark_ указывает
+            // на начало строки, а после первого экранирования - на начало участка
+            std::string_view ParseString() {
+                mark_ = pos_;
+                bool escaped = false;
+                while (true) {
+                    if (escaped) {
+                        mark_ = pos_;
+                    }
+                    do {
+                        pos_ = scan::FindJsonSpecial(pos_, end_);
+                    } while (pos_ == end_ && HasMore());
+                    if (escaped) {
+                        unescaped_.append(mark_, pos_);
+                    }
+
+                    if (!HasMore()) {
+                        throw ParsingError("String parsing error");
+                    }
+                    const char ch = *pos_++;
+                    if (ch == '"') {
+                        break;
+                    }
+                    if (ch != '\\') {
+                        throw ParsingError("Unexpected end of line"s);
+                    }
+                    if (!escaped) {
+                        escaped = true;
+                        unescaped_.assign(mark_, pos_ - 1);
+                    }
+                    if (!HasMore()) {
                         throw ParsingError("String parsing error");
                     }
-                    const char escaped_char = *(it);
+                    const char escaped_char = *pos_++;
                     switch (escaped_char) {
                     case 'n':
-                        s.push_back('\n');
+                        unescaped_.push_back('\n');
                         break;
                     case 't':
-                        s.push_back('\t');
+                        unescaped_.push_back('\t');
                         break;
                     case 'r':
-                        s.push_back('\r');
+                        unescaped_.push_back('\r');
                         break;
                     case '"':
-                        s.push_back('"');
+                        unescaped_.push_back('"');
                         break;
                     case '\\':
-                        s.push_back('\\');
+                        unescaped_.push_back('\\');
                         break;
                     default:
                         throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
                     }
                 }
-                else if (ch == '\n' || ch == '\r') {
-                    throw ParsingError("Unexpected end of line"s);
-                }
-                else {
-                    s.push_back(ch);
+                if (escaped) {
+                    return unescaped_;
                 }
-                ++it;
+                return { mark_, static_cast<size_t>(pos_ - 1 - mark_) };
             }
 
-            return Node(std::move(s));
-        }
-
-        Node LoadBool(std::istream& input) {
-            const auto s = LoadLiteral(input);
-            if (s == "true"sv) {
-                return Node{ true };
-            }
-            else if (s == "false"sv) {
-                return Node{ false };
-            }
-            else {
-                throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+            std::string_view ParseLiteral() {
+                mark_ = pos_;
+                while (HasMore() && IsAlpha(*pos_)) {
+                    ++pos_;
+                }
+                return { mark_, static_cast<size_t>(pos_ - mark_) };
             }
-        }
 
-        Node LoadNull(std::istream& input) {
-            if (auto literal = LoadLiteral(input); literal == "null"sv) {
-                return Node{ nullptr };
+            void ParseBool() {
+                const auto s = ParseLiteral();
+                if (s == "true"sv) {
+                    handler_.Bool(true);
+                }
+                else if (s == "false"sv) {
+                    handler_.Bool(false);
+                }
+                else {
+                    throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
+                }
             }
-            else {
-                throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+
+            void ParseNull() {
+                if (auto literal = ParseLiteral(); literal == "null"sv) {
+                    handler_.Null();
+                }
+                else {
+                    throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
+                }
             }
-        }
 
-        Node LoadNumber(std::istream& input) {
-            std::string parsed_num;
+            void ParseNumber() {
+                mark_ = pos_;
 
-            // Считывает в parsed_num очередной символ из input
-            auto read_char = [&parsed_num, &input] {
-                parsed_num += static_cast<char>(input.get());
-                if (!input) {
-                    throw ParsingError("Failed to read number from stream"s);
-                }
-            };
+                // Считывает одну или более цифр
+                auto read_digits = [this] {
+                    if (!HasMore() || !IsDigit(*pos_)) {
+                        throw ParsingError("A digit is expected"s);
+                    }
+                    while (HasMore() && IsDigit(*pos_)) {
+                        ++pos_;
+                    }
+                };
+                auto next_is = [this](char c) {
+                    return HasMore() && *pos_ == c;
+                };
 
-            // Считывает одну или более цифр в parsed_num из input
-            auto read_digits = [&input, read_char] {
-                if (!std::isdigit(input.peek())) {
-                    throw ParsingError("A digit is expected"s);
+                if (next_is('-')) {
+                    ++pos_;
                 }
-                while (std::isdigit(input.peek())) {
-                    read_char();
+                // Парсим целую часть числа
+                if (next_is('0')) {
+                    ++pos_;
+                    // После 0 в JSON не могут идти другие цифры
+                }
+                else {
+                    read_digits();
                 }
-            };
-
-            if (input.peek() == '-') {
-                read_char();
-            }
-            // Парсим целую часть числа
-            if (input.peek() == '0') {
-                read_char();
-                // После 0 в JSON не могут идти другие цифры
-            }
-            else {
-                read_digits();
-            }
 
-            bool is_int = true;
-            // Парсим дробную часть числа
-            if (input.peek() == '.') {
-                read_char();
-                read_digits();
-                is_int = false;
-            }
+                bool is_int = true;
+                // Парсим дробную часть числа
+                if (next_is('.')) {
+                    ++pos_;
+                    read_digits();
+                    is_int = false;
+                }
 
-            // Парсим экспоненциальную часть числа
-            if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-                read_char();
-                if (ch = input.peek(); ch == '+' || ch == '-') {
-                    read_char();
+                // Парсим экспоненциальную часть числа
+                if (next_is('e') || next_is('E')) {
+                    ++pos_;
+                    if (next_is('+') || next_is('-')) {
+                        ++pos_;
+                    }
+                    read_digits();
+                    is_int = false;
                 }
-                read_digits();
-                is_int = false;
-            }
 
-            try {
                 if (is_int) {
-                    // Сначала пробуем преобразовать строку в int
-                    try {
-                        return std::stoi(parsed_num);
-                    }
-                    catch (...) {
-                        // В случае неудачи, например, при переполнении
-                        // код ниже попробует преобразовать строку в double
+                    // Сначала пробуем преобразовать строку в int. В случае неудачи,
+                    // например, при переполнении, код ниже попробует получить double
+                    int value = 0;
+                    if (auto [ptr, ec] = std::from_chars(mark_, pos_, value); ec == std::errc{}) {
+                        handler_.Int(value);
+                        return;
                     }
                 }
-                return std::stod(parsed_num);
-            }
-            catch (...) {
-                throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
+                double value = 0;
+                if (auto [ptr, ec] = std::from_chars(mark_, pos_, value); ec == std::errc{}) {
+                    handler_.Double(value);
+                    return;
+                }
+                throw ParsingError("Failed to convert "s + std::string(mark_, pos_) + " to number"s);
             }
-        }
+        };
 
-        Node LoadNode(std::istream& input) {
-            char c;
-            if (!(input >> c)) {
-                throw ParsingError("Unexpected EOF"s);
-            }
-            switch (c) {
-            case '[':
-                return LoadArray(input);
-            case '{':
-                return LoadDict(input);
-            case '"':
-                return LoadString(input);
-            case 't':
-                // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
-                // подсказкой компилятору и человеку, что здесь программист явно задумывал
-                // разрешить переход к инструкции следующей ветки case, а не случайно забыл
-                // написать break, return или throw.
-                // В данном случае, встретив t или f, переходим к попытке парсинга
-                // литералов true либо false
-                [[fallthrough]];
-            case 'f':
-                input.putback(c);
-                return LoadBool(input);
-            case 'n':
-                input.putback(c);
-                return LoadNull(input);
-            default:
-                input.putback(c);
-                return LoadNumber(input);
-            }
-        }
+    }  // namespace
 
-        struct PrintContext {
-            std::ostream& out;
-            int indent_step = 4;
-            int indent = 0;
+    /*==========================  String  ===========================*/
 
-            void PrintIndent() const {
-                for (int i = 0; i < indent; ++i) {
-                    out.put(' ');
-                }
-            }
+    String::String(std::string_view value, std::pmr::memory_resource* resource)
+        : size_(value.size()) {
+        if (size_ > 0) {
+            char* data = static_cast<char*>(resource->allocate(size_, alignof(char)));
+            std::copy(value.begin(), value.end(), data);
+            data_ = data;
+            resource_ = resource;
+        }
+    }
 
-            PrintContext Indented() const {
-                return { out, indent_step, indent_step + indent };
-            }
-        };
+    String String::Borrow(std::string_view value) {
+        String result;
+        result.data_ = value.data();
+        result.size_ = value.size();
+        return result;
+    }
 
-        void PrintNode(const Node& value, const PrintContext& ctx);
+    String::String(const String& other)
+        : String(other.View()) {
+    }
 
-        template <typename Value>
-        void PrintValue(const Value& value, const PrintContext& ctx) {
-            ctx.out << value;
-        }
+    String::String(String&& other) noexcept
+        : data_(std::exchange(other.data_, nullptr))
+        , size_(std::exchange(other.size_, 0))
+        , resource_(std::exchange(other.resource_, nullptr)) {
+    }
 
-        void PrintString(const std::string& value, std::ostream& out) {
-            out.put('"');
-            for (const char c : value) {
-                switch (c) {
-                case '\r':
-                    out << "\\r"sv;
-                    break;
-                case '\n':
-                    out << "\\n"sv;
-                    break;
-                case '"':
-                    // Символы " и \ выводятся как \" или \\, соответственно
-                    [[fallthrough]];
-                case '\\':
-                    out.put('\\');
-                    [[fallthrough]];
-                default:
-                    out.put(c);
-                    break;
-                }
-            }
-            out.put('"');
+    String& String::operator=(const String& other) {
+        if (this != &other) {
+            *this = String(other);
         }
+        return *this;
+    }
 
-        template <>
-        void PrintValue<std::string>(const std::string& value, const PrintContext& ctx) {
-            PrintString(value, ctx.out);
+    String& String::operator=(String&& other) noexcept {
+        if (this != &other) {
+            this->~String();
+            data_ = std::exchange(other.data_, nullptr);
+            size_ = std::exchange(other.size_, 0);
+            resource_ = std::exchange(other.resource_, nullptr);
         }
+        return *this;
+    }
 
-        template <>
-        void PrintValue<std::nullptr_t>(const std::nullptr_t&, const PrintContext& ctx) {
-            ctx.out << "null"sv;
+    String::~String() {
+        if (resource_) {
+            resource_->deallocate(const_cast<char*>(data_), size_, alignof(char));
         }
+    }
+
+    std::string_view String::View() const {
+        return { data_, size_ };
+    }
+
+    String::operator std::string_view() const {
+        return View();
+    }
+
+    /*==========================  Dict  ===========================*/
+
+    namespace {
 
-        // В специализаци шаблона PrintValue для типа bool параметр value передаётся
-        // по константной ссылке, как и в основном шаблоне.
-        // В качестве альтернативы можно использовать перегрузку:
-        // void PrintValue(bool value, const PrintContext& ctx);
-        template <>
-        void PrintValue<bool>(const bool& value, const PrintContext& ctx) {
-            ctx.out << (value ? "true"sv : "false"sv);
+        template <typename Iterator>
+        Iterator LowerBound(Iterator first, Iterator last, std::string_view key) {
+            return std::lower_bound(first, last, key, [](const auto& item, std::string_view key) {
+                return std::string_view(item.first) < key;
+            });
         }
 
-        template <>
-        void PrintValue<Array>(const Array& nodes, const PrintContext& ctx) {
-            std::ostream& out = ctx.out;
-            out << "[\n"sv;
-            bool first = true;
-            auto inner_ctx = ctx.Indented();
-            for (const Node& node : nodes) {
-                if (first) {
-                    first = false;
-                }
-                else {
-                    out << ",\n"sv;
-                }
-                inner_ctx.PrintIndent();
-                PrintNode(node, inner_ctx);
-            }
-            out.put('\n');
-            ctx.PrintIndent();
-            out.put(']');
+    }  // namespace
+
+    Dict::Dict(const allocator_type& allocator)
+        : items_(allocator) {
+    }
+
+    Dict::iterator Dict::begin() {
+        return items_.begin();
+    }
+
+    Dict::iterator Dict::end() {
+        return items_.end();
+    }
+
+    Dict::const_iterator Dict::begin() const {
+        return items_.begin();
+    }
+
+    Dict::const_iterator Dict::end() const {
+        return items_.end();
+    }
+
+    size_t Dict::size() const {
+        return items_.size();
+    }
+
+    bool Dict::empty() const {
+        return items_.empty();
+    }
+
+    Dict::iterator Dict::find(std::string_view key) {
+        auto it = LowerBound(items_.begin(), items_.end(), key);
+        return it != items_.end() && it->first == key ? it : items_.end();
+    }
+
+    Dict::const_iterator Dict::find(std::string_view key) const {
+        auto it = LowerBound(items_.begin(), items_.end(), key);
+        return it != items_.end() && it->first == key ? it : items_.end();
+    }
+
+    size_t Dict::count(std::string_view key) const {
+        return find(key) != end() ? 1 : 0;
+    }
+
+    Node& Dict::at(std::string_view key) {
+        using namespace std::literals;
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("No key '"s + std::string(key) + "' in dict"s);
         }
+        return it->second;
+    }
 
-        template <>
-        void PrintValue<Dict>(const Dict& nodes, const PrintContext& ctx) {
-            std::ostream& out = ctx.out;
-            out << "{\n"sv;
-            bool first = true;
-            auto inner_ctx = ctx.Indented();
-            for (const auto& [key, node] : nodes) {
-                if (first) {
-                    first = false;
-                }
-                else {
-                    out << ",\n"sv;
-                }
-                inner_ctx.PrintIndent();
-                PrintString(key, ctx.out);
-                out << ": "sv;
-                PrintNode(node, inner_ctx);
-            }
-            out.put('\n');
-            ctx.PrintIndent();
-            out.put('}');
+    const Node& Dict::at(std::string_view key) const {
+        using namespace std::literals;
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("No key '"s + std::string(key) + "' in dict"s);
         }
+        return it->second;
+    }
+
+    Node& Dict::operator[](std::string_view key) {
+        return emplace(key, Node{}).first->second;
+    }
 
-        void PrintNode(const Node& node, const PrintContext& ctx) {
-            std::visit(
-                [&ctx](const auto& value) {
-                    PrintValue(value, ctx);
-                },
-                node.GetValue());
+    std::pair<Dict::iterator, bool> Dict::emplace(std::string_view key, Node value) {
+        auto it = LowerBound(items_.begin(), items_.end(), key);
+        if (it != items_.end() && it->first == key) {
+            return { it, false };
         }
+        it = items_.emplace(it, String(key), std::move(value));
+        return { it, true };
+    }
 
-    }  // namespace
+    bool Dict::operator==(const Dict& rhs) const {
+        return items_ == rhs.items_;
+    }
 
     /*==========================  Node  ===========================*/
 
     Node::Node(Value value)
-        : std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string>(value) {
+        : variant(std::move(value)) {
+    }
+
+    Node::Node(std::string_view value)
+        : variant(String(value)) {
+    }
+
+    Node::Node(const std::string& value)
+        : variant(String(value)) {
+    }
+
+    Node::Node(const char* value)
+        : variant(String(value)) {
     }
 
     bool Node::IsInt() const {
@@ -413,15 +577,15 @@ namespace json {
     }
 
     bool Node::IsString() const {
-        return std::holds_alternative<std::string>(*this);
+        return std::holds_alternative<String>(*this);
     }
-    const std::string& Node::AsString() const {
+    std::string_view Node::AsString() const {
         using namespace std::literals;
         if (!IsString()) {
             throw std::logic_error("Not a string"s);
         }
 
-        return std::get<std::string>(*this);
+        return std::get<String>(*this).View();
     }
 
     bool Node::IsDict() const {
@@ -458,16 +622,579 @@ namespace json {
         : root_(std::move(root)) {
     }
 
+    Document::Document(std::unique_ptr<Storage> storage, Node root)
+        : storage_(std::move(storage))
+        , root_(std::move(root)) {
+    }
+
+    Document::Document(const Document& other)
+        : root_(other.root_) {
+    }
+
+    Document& Document::operator=(const Document& other) {
+        if (this != &other) {
+            *this = Document(other);
+        }
+        return *this;
+    }
+
+    Document& Document::operator=(Document&& other) {
+        if (this != &other) {
+            // Узлы освобождаются, пока жива их память. Затем root_ не содержит
+            // контейнеров, и узлы other переносятся вместе со своим ресурсом
+            root_ = nullptr;
+            root_ = std::move(other.root_);
+            other.root_ = nullptr;
+            storage_ = std::move(other.storage_);
+        }
+        return *this;
+    }
+
     const Node& Document::GetRoot() const {
         return root_;
     }
 
+    /*==========================  TreeBuilder  ===========================*/
+
+    TreeBuilder::TreeBuilder(std::pmr::memory_resource* resource, std::string_view input)
+        : resource_(resource)
+        , input_(input) {
+    }
+
+    void TreeBuilder::StartDict() {
+        open_.push_back({ values_.size(), keys_.size() });
+    }
+
+    void TreeBuilder::EndDict() {
+        using namespace std::literals;
+        const OpenContainer container = open_.back();
+        open_.pop_back();
+
+        // Пары складываются как есть и упорядочиваются один раз
+        Dict dict(resource_);
+        auto& items = dict.items_;
+        items.reserve(values_.size() - container.first_value);
+        for (size_t i = container.first_value; i < values_.size(); ++i) {
+            items.emplace_back(std::move(keys_[container.first_key + i - container.first_value]),
+                std::move(values_[i]));
+        }
+        std::sort(items.begin(), items.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        });
+        auto duplicate = std::adjacent_find(items.begin(), items.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first == rhs.first;
+        });
+        if (duplicate != items.end()) {
+            throw ParsingError("Duplicate key '"s + std::string(duplicate->first) + "' have been found");
+        }
+        values_.resize(container.first_value);
+        keys_.resize(container.first_key);
+        AddValue(Node(std::move(dict)));
+    }
+
+    void TreeBuilder::StartArray() {
+        open_.push_back({ values_.size(), keys_.size() });
+    }
+
+    void TreeBuilder::EndArray() {
+        const OpenContainer container = open_.back();
+        open_.pop_back();
+
+        Array array(resource_);
+        array.reserve(values_.size() - container.first_value);
+        std::move(values_.begin() + container.first_value, values_.end(), std::back_inserter(array));
+        values_.resize(container.first_value);
+        AddValue(Node(std::move(array)));
+    }
+
+    void TreeBuilder::Key(std::string_view key) {
+        keys_.push_back(MakeString(key));
+    }
+
+    void TreeBuilder::String(std::string_view value) {
+        AddValue(Node(MakeString(value)));
+    }
+
+    void TreeBuilder::Int(int value) {
+        AddValue(Node(value));
+    }
+
+    void TreeBuilder::Double(double value) {
+        AddValue(Node(value));
+    }
+
+    void TreeBuilder::Bool(bool value) {
+        AddValue(Node(value));
+    }
+
+    void TreeBuilder::Null() {
+        AddValue(Node(nullptr));
+    }
+
+    bool TreeBuilder::IsComplete() const {
+        return root_.has_value();
+    }
+
+    Node TreeBuilder::Extract() {
+        using namespace std::literals;
+        if (!root_) {
+            throw std::logic_error("Node is not complete"s);
+        }
+        Node result = std::move(*root_);
+        root_.reset();
+        return result;
+    }
+
+    json::String TreeBuilder::MakeString(std::string_view value) const {
+        const std::less<const char*> less;
+        if (!input_.empty() && !less(value.data(), input_.data())
+            && !less(input_.data() + input_.size(), value.data() + value.size())) {
+            return json::String::Borrow(value);
+        }
+        return json::String(value, resource_);
+    }
+
+    void TreeBuilder::AddValue(Node value) {
+        if (open_.empty()) {
+            root_ = std::move(value);
+        }
+        else {
+            values_.push_back(std::move(value));
+        }
+    }
+
+    /*==========================  Load  ===========================*/
+
+    void Parse(std::string_view input, Handler& handler) {
+        WholeInput source(input);
+        Parser<Handler, WholeInput>(source, handler).ParseNode();
+    }
+
+    void Parse(std::istream& input, Handler& handler) {
+        ChunkedInput source(input);
+        Parser<Handler, ChunkedInput>(source, handler).ParseNode();
+    }
+
+    std::string ReadAll(std::istream& input) {
+        std::string buffer;
+        char chunk[1 << 16];
+        while (input.read(chunk, sizeof(chunk)) || input.gcount() > 0) {
+            buffer.append(chunk, static_cast<size_t>(input.gcount()));
+        }
+        return buffer;
+    }
+
+    Document Load(std::string_view input) {
+        auto storage = std::make_unique<Storage>();
+        TreeBuilder builder(&storage->arena);
+        WholeInput source(input);
+        Parser<TreeBuilder, WholeInput>(source, builder).ParseNode();
+        return Document{ std::move(storage), builder.Extract() };
+    }
+
     Document Load(std::istream& input) {
-        return Document{ LoadNode(input) };
+        auto storage = std::make_unique<Storage>();
+        storage->input = ReadAll(input);
+        TreeBuilder builder(&storage->arena, storage->input);
+        WholeInput source(storage->input);
+        Parser<TreeBuilder, WholeInput>(source, builder).ParseNode();
+        return Document{ std::move(storage), builder.Extract() };
+    }
+
+    /*==========================  Split  ===========================*/
+
+    namespace {
+        const char* SkipSpaces(const char* pos, const char* end) {
+            while (pos != end && IsSpace(*pos)) {
+                ++pos;
+            }
+            return pos;
+        }
+
+        // Вызывается после открывающей кавычки, возвращает позицию закрывающей
+        const char* SkipString(const char* pos, const char* end) {
+            while ((pos = scan::FindQuoteOrBackslash(pos, end)) != end && *pos != '"') {
+                if (++pos == end) {
+                    break;
+                }
+                ++pos;
+            }
+            if (pos == end) {
+                throw ParsingError("String parsing error"s);
+            }
+            return pos;
+        }
+
+        // Возвращает позицию, на которой Parser закончил бы читать true,
+        // false, null или число. Правильность самих значений проверяется
+        // при разборе куска
+        const char* SkipScalar(const char* pos, const char* end) {
+            if (IsAlpha(*pos)) {
+                while (pos != end && IsAlpha(*pos)) {
+                    ++pos;
+                }
+                return pos;
+            }
+
+            const char* begin = pos;
+            auto skip_digits = [&pos, end] {
+                while (pos != end && IsDigit(*pos)) {
+                    ++pos;
+                }
+            };
+            if (*pos == '-') {
+                ++pos;
+            }
+            if (pos != end && *pos == '0') {
+                ++pos;
+            }
+            else {
+                skip_digits();
+            }
+            if (pos != end && *pos == '.') {
+                ++pos;
+                skip_digits();
+            }
+            if (pos != end && (*pos == 'e' || *pos == 'E')) {
+                ++pos;
+                if (pos != end && (*pos == '+' || *pos == '-')) {
+                    ++pos;
+                }
+                skip_digits();
+            }
+            if (pos == begin) {
+                throw ParsingError("A digit is expected"s);
+            }
+            return pos;
+        }
+
+        // Возвращает позицию сразу за значением, которое начинается в pos
+        const char* SkipValue(const char* pos, const char* end) {
+            if (pos == end) {
+                throw ParsingError("Unexpected EOF"s);
+            }
+            if (*pos == '"') {
+                return SkipString(pos + 1, end) + 1;
+            }
+            if (*pos != '[' && *pos != '{') {
+                return SkipScalar(pos, end);
+            }
+
+            size_t depth = 0;
+            for (; (pos = scan::FindStructural(pos, end)) != end; ++pos) {
+                switch (*pos) {
+                case '"':
+                    pos = SkipString(pos + 1, end);
+                    break;
+                case '[':
+                    [[fallthrough]];
+                case '{':
+                    ++depth;
+                    break;
+                case ']':
+                    [[fallthrough]];
+                case '}':
+                    if (--depth == 0) {
+                        return pos + 1;
+                    }
+                    break;
+                }
+            }
+            throw ParsingError("Unexpected EOF"s);
+        }
+    }  // namespace
+
+    std::vector<std::string_view> SplitArray(std::string_view array) {
+        const char* end = array.data() + array.size();
+        const char* pos = SkipSpaces(array.data(), end);
+        if (pos == end || *pos != '[') {
+            throw ParsingError("Array parsing error"s);
+        }
+
+        // Запятые пропускаются так же, как в Parser::ParseArray: перед
+        // элементом может стоять одна запятая, а может не стоять ни одной
+        std::vector<std::string_view> elements;
+        ++pos;
+        while (true) {
+            pos = SkipSpaces(pos, end);
+            if (pos == end) {
+                throw ParsingError("Array parsing error"s);
+            }
+            if (*pos == ']') {
+                return elements;
+            }
+            if (*pos == ',') {
+                pos = SkipSpaces(pos + 1, end);
+            }
+            const char* begin = pos;
+            pos = SkipValue(pos, end);
+            elements.emplace_back(begin, static_cast<size_t>(pos - begin));
+        }
+    }
+
+    std::vector<std::pair<std::string_view, std::string_view>> SplitDict(std::string_view dict) {
+        const char* end = dict.data() + dict.size();
+        const char* pos = SkipSpaces(dict.data(), end);
+        if (pos == end || *pos != '{') {
+            throw ParsingError("Dictionary parsing error"s);
+        }
+
+        // Как и в Parser::ParseDict, между ключами может стоять сколько
+        // угодно запятых, в том числе ни одной
+        std::vector<std::pair<std::string_view, std::string_view>> members;
+        ++pos;
+        while (true) {
+            pos = SkipSpaces(pos, end);
+            if (pos == end) {
+                throw ParsingError("Dictionary parsing error"s);
+            }
+            if (*pos == '}') {
+                return members;
+            }
+            const char c = *pos++;
+            if (c == ',') {
+                continue;
+            }
+            if (c != '"') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            }
+            const char* key = pos;
+            pos = SkipString(key, end);
+            const std::string_view key_view(key, static_cast<size_t>(pos - key));
+
+            pos = SkipSpaces(pos + 1, end);
+            if (pos == end || *pos != ':') {
+                throw ParsingError(": is expected but '"s
+                    + (pos == end ? ""s : std::string(1, *pos)) + "' has been found"s);
+            }
+            pos = SkipSpaces(pos + 1, end);
+            const char* value = pos;
+            pos = SkipValue(pos, end);
+            members.emplace_back(key_view, std::string_view(value, static_cast<size_t>(pos - value)));
+        }
+    }
+
+    /*==========================  Writer  ===========================*/
+
+    namespace {
+        constexpr size_t WRITER_BUFFER_SIZE = 1 << 16;
+        constexpr int INDENT_STEP = 4;
+    }  // namespace
+
+    Writer::Writer(std::ostream& output, Format format)
+        : output_(output)
+        , format_(format)
+        , buffer_(std::make_unique<char[]>(WRITER_BUFFER_SIZE)) {
+    }
+
+    Writer::~Writer() {
+        Drain();
+    }
+
+    void Writer::StartDict() {
+        BeforeValue();
+        Put('{');
+        first_in_level_.push_back(true);
+    }
+
+    void Writer::EndDict() {
+        EndContainer('}');
+    }
+
+    void Writer::StartArray() {
+        BeforeValue();
+        Put('[');
+        first_in_level_.push_back(true);
+    }
+
+    void Writer::EndArray() {
+        EndContainer(']');
+    }
+
+    void Writer::Key(std::string_view key) {
+        using namespace std::literals;
+        BeforeValue();
+        WriteString(key);
+        Write(format_ == Format::PRETTY ? ": "sv : ":"sv);
+        after_key_ = true;
+    }
+
+    void Writer::String(std::string_view value) {
+        BeforeValue();
+        WriteString(value);
+    }
+
+    void Writer::Int(int value) {
+        BeforeValue();
+        char chars[16];
+        auto [end, ec] = std::to_chars(chars, chars + sizeof(chars), value);
+        Write({ chars, static_cast<size_t>(end - chars) });
+    }
+
+    void Writer::Double(double value) {
+        BeforeValue();
+        char chars[32];
+        auto [end, ec] = std::to_chars(chars, chars + sizeof(chars), value);
+        Write({ chars, static_cast<size_t>(end - chars) });
+    }
+
+    void Writer::Bool(bool value) {
+        using namespace std::literals;
+        BeforeValue();
+        Write(value ? "true"sv : "false"sv);
+    }
+
+    void Writer::Null() {
+        using namespace std::literals;
+        BeforeValue();
+        Write("null"sv);
+    }
+
+    void Writer::Value(const Node& node) {
+        std::visit([this](const auto& value) {
+            using T = std::decay_t<decltype(value)>;
+            if constexpr (std::is_same_v<T, std::nullptr_t>) {
+                Null();
+            }
+            else if constexpr (std::is_same_v<T, Array>) {
+                StartArray();
+                for (const Node& item : value) {
+                    Value(item);
+                }
+                EndArray();
+            }
+            else if constexpr (std::is_same_v<T, Dict>) {
+                StartDict();
+                for (const auto& [key, item] : value) {
+                    Key(key.View());
+                    Value(item);
+                }
+                EndDict();
+            }
+            else if constexpr (std::is_same_v<T, bool>) {
+                Bool(value);
+            }
+            else if constexpr (std::is_same_v<T, int>) {
+                Int(value);
+            }
+            else if constexpr (std::is_same_v<T, double>) {
+                Double(value);
+            }
+            else {
+                String(value.View());
+            }
+        }, node.GetValue());
+    }
+
+    void Writer::EndLine() {
+        Put('\n');
+    }
+
+    void Writer::Flush() {
+        Drain();
+        output_.flush();
+    }
+
+    // Ставит разделитель перед очередным значением или ключом. Значение
+    // после ключа идёт в той же строке
+    void Writer::BeforeValue() {
+        if (after_key_) {
+            after_key_ = false;
+            return;
+        }
+        if (first_in_level_.empty()) {
+            return;
+        }
+        if (!first_in_level_.back()) {
+            Put(',');
+        }
+        first_in_level_.back() = false;
+        if (format_ == Format::PRETTY) {
+            NewLine();
+        }
+    }
+
+    // Пустой контейнер в форматированном виде занимает две строки,
+    // как и раньше выводил Print
+    void Writer::EndContainer(char bracket) {
+        const bool was_empty = first_in_level_.back();
+        first_in_level_.pop_back();
+        if (format_ == Format::PRETTY) {
+            if (was_empty) {
+                Put('\n');
+            }
+            NewLine();
+        }
+        Put(bracket);
+    }
+
+    void Writer::NewLine() {
+        Put('\n');
+        const size_t indent = first_in_level_.size() * INDENT_STEP;
+        for (size_t i = 0; i < indent; ++i) {
+            Put(' ');
+        }
+    }
+
+    void Writer::Drain() {
+        output_.write(buffer_.get(), static_cast<std::streamsize>(size_));
+        size_ = 0;
+    }
+
+    void Writer::Put(char c) {
+        if (size_ == WRITER_BUFFER_SIZE) {
+            Drain();
+        }
+        buffer_[size_++] = c;
+    }
+
+    void Writer::Write(std::string_view text) {
+        if (text.size() > WRITER_BUFFER_SIZE - size_) {
+            Drain();
+            if (text.size() >= WRITER_BUFFER_SIZE) {
+                output_.write(text.data(), static_cast<std::streamsize>(text.size()));
+                return;
+            }
+        }
+        std::copy(text.begin(), text.end(), buffer_.get() + size_);
+        size_ += text.size();
+    }
+
+    // Символы " и \ выводятся как \" и \\, переводы строк как \r и \n.
+    // Участки между ними копируются целиком
+    void Writer::WriteString(std::string_view value) {
+        using namespace std::literals;
+        Put('"');
+        const char* pos = value.data();
+        const char* end = pos + value.size();
+        while (pos != end) {
+            const char* run = pos;
+            pos = scan::FindJsonSpecial(pos, end);
+            Write({ run, static_cast<size_t>(pos - run) });
+            if (pos == end) {
+                break;
+            }
+            switch (*pos++) {
+            case '\r':
+                Write("\\r"sv);
+                break;
+            case '\n':
+                Write("\\n"sv);
+                break;
+            case '"':
+                Write("\\\""sv);
+                break;
+            default:
+                Write("\\\\"sv);
+                break;
+            }
+        }
+        Put('"');
     }
 
-    void Print(const Document& doc, std::ostream& output) {
-        PrintNode(doc.GetRoot(), PrintContext{ output });
+    void Print(const Document& doc, std::ostream& output, Format format) {
+        Writer writer(output, format);
+        writer.Value(doc.GetRoot());
     }
 
 }  // namespace json
@@ -1,16 +1,104 @@
 #pragma once
 
 #include <iostream>
-#include <map>
+#include <memory>
+#include <memory_resource>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <variant>
 #include <vector>
 
 namespace json {
 
     class Node;
-    using Dict = std::map<std::string, Node>;
-    using Array = std::vector<Node>;
+    class TreeBuilder;
+
+    // Строка узла. Либо ссылается на чужую память (например, на входной буфер
+    // документа), либо владеет копией, выделенной у memory_resource.
+    // Копия String всегда владеет своими данными и берёт их из кучи
+    class String {
+    public:
+        String() = default;
+        explicit String(std::string_view value,
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+        // Строка без копирования. Память value должна пережить строку и её перемещения
+        static String Borrow(std::string_view value);
+
+        String(const String& other);
+        String(String&& other) noexcept;
+        String& operator=(const String& other);
+        String& operator=(String&& other) noexcept;
+        ~String();
+
+        std::string_view View() const;
+        operator std::string_view() const;
+
+    private:
+        const char* data_ = nullptr;
+        size_t size_ = 0;
+        // Ресурс, выделивший data_, или nullptr для ссылки на чужую память
+        std::pmr::memory_resource* resource_ = nullptr;
+    };
+
+    inline bool operator==(const String& lhs, const String& rhs) {
+        return lhs.View() == rhs.View();
+    }
+
+    inline bool operator!=(const String& lhs, const String& rhs) {
+        return !(lhs == rhs);
+    }
+
+    inline bool operator<(const String& lhs, const String& rhs) {
+        return lhs.View() < rhs.View();
+    }
+
+    // Контейнеры узлов берут память у memory_resource. Узлы, созданные вне
+    // документа, используют ресурс по умолчанию, т.е. обычную кучу
+    using Array = std::pmr::vector<Node>;
+
+    // Словарь хранит пары в векторе, упорядоченном по ключу. В объектах JSON
+    // обычно немного ключей, и двоичный поиск в непрерывной памяти быстрее
+    // обхода дерева. Обход идёт в порядке возрастания ключей, как у std::map
+    class Dict {
+    public:
+        using value_type = std::pair<String, Node>;
+        using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+        using iterator = std::pmr::vector<value_type>::iterator;
+        using const_iterator = std::pmr::vector<value_type>::const_iterator;
+
+        Dict() = default;
+        explicit Dict(const allocator_type& allocator);
+
+        iterator begin();
+        iterator end();
+        const_iterator begin() const;
+        const_iterator end() const;
+
+        size_t size() const;
+        bool empty() const;
+
+        iterator find(std::string_view key);
+        const_iterator find(std::string_view key) const;
+        size_t count(std::string_view key) const;
+
+        // Бросает std::out_of_range, если ключа нет
+        Node& at(std::string_view key);
+        const Node& at(std::string_view key) const;
+
+        // Добавляет пустой узел, если ключа нет
+        Node& operator[](std::string_view key);
+        std::pair<iterator, bool> emplace(std::string_view key, Node value);
+
+        bool operator==(const Dict& rhs) const;
+
+    private:
+        friend class TreeBuilder;
+
+        std::pmr::vector<value_type> items_;
+    };
 
     class ParsingError : public std::runtime_error {
     public:
@@ -18,12 +106,15 @@ namespace json {
     };
 
     class Node final
-        : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, std::string> {
+        : private std::variant<std::nullptr_t, Array, Dict, bool, int, double, String> {
     public:
         using variant::variant;
         using Value = variant;
 
         Node(Value value);
+        Node(std::string_view value);
+        Node(const std::string& value);
+        Node(const char* value);
 
         bool IsInt() const;
         int AsInt() const;
@@ -41,7 +132,7 @@ namespace json {
         const Array& AsArray() const;
 
         bool IsString() const;
-        const std::string& AsString() const;
+        std::string_view AsString() const;
 
         bool IsDict() const;
         const Dict& AsDict() const;
@@ -56,13 +147,34 @@ namespace json {
         return !(lhs == rhs);
     }
 
+    using Arena = std::pmr::monotonic_buffer_resource;
+
+    // Память разобранного документа: входной буфер, на который ссылаются
+    // строки без экранирования, и арена для узлов и остальных строк
+    struct Storage {
+        std::string input;
+        Arena arena;
+    };
+
     class Document {
     public:
         explicit Document();
         explicit Document(Node root);
+        // Все узлы root должны быть размещены в storage
+        Document(std::unique_ptr<Storage> storage, Node root);
+
+        // Копия не зависит от арены исходного документа
+        Document(const Document& other);
+        Document& operator=(const Document& other);
+        Document(Document&& other) = default;
+        Document& operator=(Document&& other);
+
         const Node& GetRoot() const;
 
     private:
+        // Память объявлена первой, чтобы пережить узлы, которые в ней лежат.
+        // Освобождение узлов в арене ничего не стоит, память возвращается разом
+        std::unique_ptr<Storage> storage_;
         Node root_;
     };
 
@@ -74,8 +186,143 @@ namespace json {
         return !(lhs == rhs);
     }
 
+    // Получатель событий потокового разбора. Строки и ключи передаются
+    // ссылками, которые действительны только до возврата из обработчика
+    class Handler {
+    public:
+        virtual void StartDict() = 0;
+        virtual void EndDict() = 0;
+        virtual void StartArray() = 0;
+        virtual void EndArray() = 0;
+        virtual void Key(std::string_view key) = 0;
+        virtual void String(std::string_view value) = 0;
+        virtual void Int(int value) = 0;
+        virtual void Double(double value) = 0;
+        virtual void Bool(bool value) = 0;
+        virtual void Null() = 0;
+
+    protected:
+        ~Handler() = default;
+    };
+
+    // Собирает из событий разбора одно значение в виде Node.
+    // Память под узлы берётся у resource. Строки, лежащие внутри input,
+    // не копируются, а ссылаются на него
+    class TreeBuilder final : public Handler {
+    public:
+        explicit TreeBuilder(std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+            std::string_view input = {});
+
+        void StartDict() override;
+        void EndDict() override;
+        void StartArray() override;
+        void EndArray() override;
+        void Key(std::string_view key) override;
+        void String(std::string_view value) override;
+        void Int(int value) override;
+        void Double(double value) override;
+        void Bool(bool value) override;
+        void Null() override;
+
+        bool IsComplete() const;
+        Node Extract();
+
+    private:
+        struct OpenContainer {
+            size_t first_value;
+            size_t first_key;
+        };
+
+        std::pmr::memory_resource* resource_;
+        std::string_view input_;
+        // Готовые значения и ключи ещё не закрытых контейнеров. Контейнер
+        // создаётся сразу нужного размера, когда известны все его элементы
+        std::vector<Node> values_;
+        std::vector<json::String> keys_;
+        std::vector<OpenContainer> open_;
+        std::optional<Node> root_;
+
+        json::String MakeString(std::string_view value) const;
+        void AddValue(Node value);
+    };
+
+    // Разбирает документ, сообщая о каждом значении обработчику
+    void Parse(std::string_view input, Handler& handler);
+    // Читает поток блоками по мере разбора, не загружая документ целиком
+    void Parse(std::istream& input, Handler& handler);
+
+    // Считывает поток до конца
+    std::string ReadAll(std::istream& input);
+
+    // Разбирает документ, целиком лежащий в памяти. Строки копируются в арену документа
+    Document Load(std::string_view input);
+    // Считывает поток до конца в буфер, которым владеет документ.
+    // Строки без экранирования ссылаются на этот буфер
     Document Load(std::istream& input);
 
-    void Print(const Document& doc, std::ostream& output);
+    // Находят границы значений верхнего уровня в массиве или словаре, не разбирая
+    // сами значения: отслеживаются только кавычки и скобки. Запятые и концы
+    // чисел определяются так же, как при разборе, поэтому куски те же, что
+    // прочитал бы Load. Их можно разбирать независимо, в том числе
+    // параллельно. Ключи словаря возвращаются без кавычек и без обработки
+    // экранирования
+    std::vector<std::string_view> SplitArray(std::string_view array);
+    std::vector<std::pair<std::string_view, std::string_view>> SplitDict(std::string_view dict);
+
+    enum class Format {
+        PRETTY,
+        COMPACT
+    };
+
+    // Выводит JSON по событиям. Текст копится в собственном буфере и уходит
+    // в поток крупными блоками. Вещественные числа выводятся кратчайшей
+    // записью, которая читается обратно в то же значение
+    class Writer final : public Handler {
+    public:
+        explicit Writer(std::ostream& output, Format format = Format::PRETTY);
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+        ~Writer();
+
+        void StartDict() override;
+        void EndDict() override;
+        void StartArray() override;
+        void EndArray() override;
+        void Key(std::string_view key) override;
+        void String(std::string_view value) override;
+        void Int(int value) override;
+        void Double(double value) override;
+        void Bool(bool value) override;
+        void Null() override;
+
+        void Value(const Node& node);
+
+        // Переводит строку между документами, когда каждый ответ
+        // выводится в своей строке
+        void EndLine();
+
+        // Отдаёт накопленный текст в поток и сбрасывает буфер потока
+        void Flush();
+
+    private:
+        std::ostream& output_;
+        Format format_;
+        std::unique_ptr<char[]> buffer_;
+        size_t size_ = 0;
+        // Для каждого открытого контейнера: не было ли в нём ещё элементов
+        std::vector<bool> first_in_level_;
+        bool after_key_ = false;
+
+        void BeforeValue();
+        void EndContainer(char bracket);
+        // Отдаёт накопленный текст в поток, не сбрасывая буфер потока
+        void Drain();
+        void NewLine();
+        void Put(char c);
+        void Write(std::string_view text);
+        void WriteString(std::string_view value);
+    };
+
+    void Print(const Document& doc, std::ostream& output, Format format = Format::PRETTY);
 
 }  // namespace json
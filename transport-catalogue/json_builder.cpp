@@ -7,80 +7,27 @@ using namespace std;
 
 namespace json {
 
-	//====================  KeyItemContext  ==================================
-
-	KeyItemContext::KeyItemContext(Builder& builder)
-		: builder_(builder) {
-	}
-
-	DictItemContext KeyItemContext::Value(Node::Value value) {
-		return DictItemContext{ builder_.Value(std::move(value)) };
-	}
-
-	DictItemContext KeyItemContext::StartDict() {
-		return builder_.StartDict();
-	}
-
-	ArrayItemContext KeyItemContext::StartArray() {
-		return builder_.StartArray();
-	}
-
-	//====================  DictItemContext  =================================
-
-	DictItemContext::DictItemContext(Builder& builder) 
-		: builder_(builder) {
-	}
-
-	KeyItemContext DictItemContext::Key(std::string key) {
-		return builder_.Key(std::move(key));
-	}
-
-	Builder& DictItemContext::EndDict() {
-		return builder_.EndDict();
-	}
-
-	//====================  ArrayItemContext  ====================================
-
-	ArrayItemContext::ArrayItemContext(Builder& builder) 
-		: builder_(builder) {
-	}
-
-	ArrayItemContext ArrayItemContext::Value(Node::Value value) {
-		return ArrayItemContext{ builder_.Value(std::move(value)) };
-	}
-
-	DictItemContext ArrayItemContext::StartDict() {
-		return builder_.StartDict();
-	}
-
-	ArrayItemContext ArrayItemContext::StartArray() {
-		return builder_.StartArray();
-	}
-
-	Builder& ArrayItemContext::EndArray() {
-		return builder_.EndArray();
-	}
-
 	//====================  Builder  =========================================
 
-	KeyItemContext Builder::Key(std::string key) {
+	KeyItemContext<Builder> Builder::Key(std::string_view key) {
 		if (nodes_stack_.empty() || !nodes_stack_.back()->IsDict()) {
 			throw std::logic_error("Failed Key(): the last element of the vector is not a dictionary"s);
 		}
-		nodes_stack_.emplace_back(&std::get<Dict>(nodes_stack_.back()->GetNoConstValue())[key]);
-		return KeyItemContext{ *this };
+		Dict& dict = std::get<Dict>(nodes_stack_.back()->GetNoConstValue());
+		nodes_stack_.emplace_back(&dict[key]);
+		return KeyItemContext<Builder>{ *this };
 	}
 
-	Builder& Builder::Value(Node::Value value) {
+	Builder& Builder::Value(Node value) {
 		if (nodes_stack_.empty() && std::holds_alternative<nullptr_t>(root_.GetValue())) {
-			root_ = value;
+			root_ = std::move(value);
 		}
 		else if (!nodes_stack_.empty() && nodes_stack_.back()->IsNull()) {
-			nodes_stack_.back()->GetNoConstValue() = value;
+			*nodes_stack_.back() = std::move(value);
 			nodes_stack_.erase(nodes_stack_.end() - 1);
 		}
 		else if (!nodes_stack_.empty() && nodes_stack_.back()->IsArray()) {
-			std::get<Array>(nodes_stack_.back()->GetNoConstValue()).push_back(value);
+			std::get<Array>(nodes_stack_.back()->GetNoConstValue()).push_back(std::move(value));
 		}
 		else {
 			throw std::logic_error("Failed Value()"s);
@@ -96,8 +43,8 @@ namespace json {
 		throw std::logic_error("Failed Build()"s);
 	}
 
-	DictItemContext Builder::StartDict() {
-		return DictItemContext{ this->StartContainer(Dict{}) };
+	DictItemContext<Builder> Builder::StartDict() {
+		return DictItemContext<Builder>{ this->StartContainer(Dict{}) };
 	}
 
 	Builder& Builder::EndDict() {
@@ -111,8 +58,8 @@ namespace json {
 		return *this;
 	}
 
-	ArrayItemContext Builder::StartArray() {
-		return ArrayItemContext{ this->StartContainer(Array{}) };
+	ArrayItemContext<Builder> Builder::StartArray() {
+		return ArrayItemContext<Builder>{ this->StartContainer(Array{}) };
 	}
 
 	Builder& Builder::EndArray() {
@@ -125,4 +72,77 @@ namespace json {
 
 		return *this;
 	}
+
+	//====================  StreamBuilder  ===================================
+
+	StreamBuilder::StreamBuilder(Writer& writer)
+		: writer_(writer) {
+	}
+
+	KeyItemContext<StreamBuilder> StreamBuilder::Key(std::string_view key) {
+		if (levels_.empty() || levels_.back() != Level::DICT) {
+			throw std::logic_error("Failed Key(): the last element of the vector is not a dictionary"s);
+		}
+		writer_.Key(key);
+		levels_.push_back(Level::KEY);
+		return KeyItemContext<StreamBuilder>{ *this };
+	}
+
+	DictItemContext<StreamBuilder> StreamBuilder::StartDict() {
+		BeforeValue("Failed StartDict()");
+		writer_.StartDict();
+		levels_.push_back(Level::DICT);
+		return DictItemContext<StreamBuilder>{ *this };
+	}
+
+	StreamBuilder& StreamBuilder::EndDict() {
+		if (levels_.empty() || levels_.back() != Level::DICT) {
+			throw std::logic_error("Failed EndDict()"s);
+		}
+		levels_.pop_back();
+		writer_.EndDict();
+		AfterValue();
+
+		return *this;
+	}
+
+	ArrayItemContext<StreamBuilder> StreamBuilder::StartArray() {
+		BeforeValue("Failed StartArray()");
+		writer_.StartArray();
+		levels_.push_back(Level::ARRAY);
+		return ArrayItemContext<StreamBuilder>{ *this };
+	}
+
+	StreamBuilder& StreamBuilder::EndArray() {
+		if (levels_.empty() || levels_.back() != Level::ARRAY) {
+			throw std::logic_error("Failed EndArray()"s);
+		}
+		levels_.pop_back();
+		writer_.EndArray();
+		AfterValue();
+
+		return *this;
+	}
+
+	void StreamBuilder::Finish() const {
+		if (!complete_) {
+			throw std::logic_error("Failed Finish()"s);
+		}
+	}
+
+	// A value may start the document, go into an array or follow a key
+	void StreamBuilder::BeforeValue(const char* operation) {
+		if (levels_.empty() ? complete_ : levels_.back() == Level::DICT) {
+			throw std::logic_error(operation);
+		}
+		if (!levels_.empty() && levels_.back() == Level::KEY) {
+			levels_.pop_back();
+		}
+	}
+
+	void StreamBuilder::AfterValue() {
+		if (levels_.empty()) {
+			complete_ = true;
+		}
+	}
 }
@@ -3,25 +3,27 @@
 #include "json.h"
 
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 namespace json {
 
-	class DictItemContext;
-	class KeyItemContext;
-	class ArrayItemContext;
+	template<typename Owner> class DictItemContext;
+	template<typename Owner> class KeyItemContext;
+	template<typename Owner> class ArrayItemContext;
 
 	class Builder {
 	public:
 		Builder() = default;
 
 		Builder& EndDict();
-		Builder& Value(Node::Value value);
+		Builder& Value(Node value);
 		Builder& EndArray();
 
-		DictItemContext StartDict();
-		ArrayItemContext StartArray();
-		KeyItemContext Key(std::string key);
+		DictItemContext<Builder> StartDict();
+		ArrayItemContext<Builder> StartArray();
+		KeyItemContext<Builder> Key(std::string_view key);
 
 		Node Build() const;
 	private:
@@ -32,37 +34,107 @@ namespace json {
 		Builder& StartContainer(Container container);
 	};
 
+	// Same API as Builder, but every call goes straight to the Writer,
+	// so no tree is kept in memory
+	class StreamBuilder {
+	public:
+		explicit StreamBuilder(Writer& writer);
+
+		StreamBuilder& EndDict();
+		template<typename T>
+		StreamBuilder& Value(T&& value);
+		StreamBuilder& EndArray();
+
+		DictItemContext<StreamBuilder> StartDict();
+		ArrayItemContext<StreamBuilder> StartArray();
+		KeyItemContext<StreamBuilder> Key(std::string_view key);
+
+		// Throws if the root value is not written completely
+		void Finish() const;
+	private:
+		enum class Level {
+			ARRAY,
+			DICT,
+			KEY
+		};
+
+		Writer& writer_;
+		std::vector<Level> levels_;
+		bool complete_ = false;
+
+		void BeforeValue(const char* operation);
+		void AfterValue();
+	};
+
 	// 1
+	template<typename Owner>
 	class KeyItemContext {
 	public:
-		KeyItemContext(Builder& builder);
-		DictItemContext Value(Node::Value value);
-		DictItemContext StartDict();
-		ArrayItemContext StartArray();
+		KeyItemContext(Owner& builder)
+			: builder_(builder) {
+		}
+
+		template<typename T>
+		DictItemContext<Owner> Value(T&& value) {
+			return DictItemContext<Owner>{ builder_.Value(std::forward<T>(value)) };
+		}
+
+		DictItemContext<Owner> StartDict() {
+			return builder_.StartDict();
+		}
+
+		ArrayItemContext<Owner> StartArray() {
+			return builder_.StartArray();
+		}
 	private:
-		Builder& builder_;
+		Owner& builder_;
 	};
 
 	// 2
+	template<typename Owner>
 	class DictItemContext {
 	public:
-		DictItemContext(Builder& builder);
-		KeyItemContext Key(std::string key);
-		Builder& EndDict();
+		DictItemContext(Owner& builder)
+			: builder_(builder) {
+		}
+
+		KeyItemContext<Owner> Key(std::string_view key) {
+			return builder_.Key(key);
+		}
+
+		Owner& EndDict() {
+			return builder_.EndDict();
+		}
 	private:
-		Builder& builder_;
+		Owner& builder_;
 	};
 
 	// 3
+	template<typename Owner>
 	class ArrayItemContext {
 	public:
-		ArrayItemContext(Builder& builder);
-		ArrayItemContext Value(Node::Value value);
-		DictItemContext StartDict();
-		ArrayItemContext StartArray();
-		Builder& EndArray();
+		ArrayItemContext(Owner& builder)
+			: builder_(builder) {
+		}
+
+		template<typename T>
+		ArrayItemContext Value(T&& value) {
+			return ArrayItemContext{ builder_.Value(std::forward<T>(value)) };
+		}
+
+		DictItemContext<Owner> StartDict() {
+			return builder_.StartDict();
+		}
+
+		ArrayItemContext StartArray() {
+			return builder_.StartArray();
+		}
+
+		Owner& EndArray() {
+			return builder_.EndArray();
+		}
 	private:
-		Builder& builder_;
+		Owner& builder_;
 	};
 
 	template<typename Container>
@@ -84,4 +156,32 @@ namespace json {
 
 		return *this;
 	}
+
+	template<typename T>
+	StreamBuilder& StreamBuilder::Value(T&& value) {
+		using Type = std::decay_t<T>;
+
+		BeforeValue("Failed Value()");
+		if constexpr (std::is_same_v<Type, Node>) {
+			writer_.Value(value);
+		}
+		else if constexpr (std::is_convertible_v<const Type&, std::string_view>) {
+			writer_.String(value);
+		}
+		else if constexpr (std::is_same_v<Type, bool>) {
+			writer_.Bool(value);
+		}
+		else if constexpr (std::is_same_v<Type, int>) {
+			writer_.Int(value);
+		}
+		else if constexpr (std::is_same_v<Type, double>) {
+			writer_.Double(value);
+		}
+		else {
+			writer_.Value(Node(std::forward<T>(value)));
+		}
+		AfterValue();
+
+		return *this;
+	}
 }
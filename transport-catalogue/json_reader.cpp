@@ -4,6 +4,8 @@
 #include "router.h"
 #include "domain.h"
 #include "transport_router.h"
+#include "parallel.h"
+#include "snapshot.h"
 
 #include <stdexcept>
 #include <vector>
@@ -12,9 +14,215 @@
 #include <utility>
 #include <sstream>
 #include <unordered_set>
+#include <functional>
+#include <optional>
+#include <cmath>
 
 namespace catalogue {
 
+	namespace {
+
+		constexpr size_t PARSE_BLOCK_SIZE = 256;
+
+		// Departures are within a week from the start of the day, and a bus
+		// makes no more trips than one a minute for a week
+		constexpr double MAX_DEPARTURE = 7 * 24 * 60;
+		constexpr size_t MAX_TRIPS = 7 * 24 * 60;
+
+		void CheckDeparture(double departure) {
+			if (!(departure >= 0 && departure <= MAX_DEPARTURE)) {
+				throw std::logic_error("departure should be within a week from the start of the day");
+			}
+		}
+
+		// Streams the input document: every element of base_requests is handed
+		// to on_base_request as soon as it is parsed, the other sections are
+		// collected as whole nodes. If on_stat_request is set, elements of
+		// stat_requests are handed to it the same way
+		class InputHandler final : public json::Handler {
+		public:
+			using StatRequestCallback = std::function<void(const json::Node&, const InputHandler&)>;
+
+			// Strings of base requests that need no unescaping refer to input
+			InputHandler(std::string_view input, std::function<void(const json::Node&)> on_base_request,
+				StatRequestCallback on_stat_request = nullptr)
+				: on_base_request_(std::move(on_base_request))
+				, on_stat_request_(std::move(on_stat_request))
+				, builder_(std::pmr::get_default_resource(), input) {
+			}
+
+			void StartDict() override {
+				if (state_ == State::ROOT) {
+					state_ = State::SECTIONS;
+					return;
+				}
+				Forward([](json::Handler& h) { h.StartDict(); });
+			}
+
+			void EndDict() override {
+				if (!forwarding_ && state_ == State::SECTIONS) {
+					state_ = State::DONE;
+					return;
+				}
+				Forward([](json::Handler& h) { h.EndDict(); });
+			}
+
+			void StartArray() override {
+				if (!forwarding_ && state_ == State::SECTIONS && key_ == "base_requests") {
+					CheckNotRepeated(has_base_requests_);
+					state_ = State::BASE_REQUESTS;
+					has_base_requests_ = true;
+					return;
+				}
+				if (!forwarding_ && state_ == State::SECTIONS && key_ == "stat_requests" && on_stat_request_) {
+					CheckNotRepeated(has_stat_requests_);
+					state_ = State::STAT_REQUESTS;
+					has_stat_requests_ = true;
+					return;
+				}
+				Forward([](json::Handler& h) { h.StartArray(); });
+			}
+
+			void EndArray() override {
+				if (!forwarding_ && state_ == State::BASE_REQUESTS) {
+					state_ = State::SECTIONS;
+					base_requests_done_ = true;
+					return;
+				}
+				if (!forwarding_ && state_ == State::STAT_REQUESTS) {
+					state_ = State::SECTIONS;
+					return;
+				}
+				Forward([](json::Handler& h) { h.EndArray(); });
+			}
+
+			void Key(std::string_view key) override {
+				if (!forwarding_ && state_ == State::SECTIONS) {
+					key_ = key;
+					return;
+				}
+				Forward([key](json::Handler& h) { h.Key(key); });
+			}
+
+			void String(std::string_view value) override {
+				Forward([value](json::Handler& h) { h.String(value); });
+			}
+
+			void Int(int value) override {
+				Forward([value](json::Handler& h) { h.Int(value); });
+			}
+
+			void Double(double value) override {
+				Forward([value](json::Handler& h) { h.Double(value); });
+			}
+
+			void Bool(bool value) override {
+				Forward([value](json::Handler& h) { h.Bool(value); });
+			}
+
+			void Null() override {
+				Forward([](json::Handler& h) { h.Null(); });
+			}
+
+			bool HasAllSections() const {
+				return has_base_requests_
+					&& (has_stat_requests_ || sections_.count("stat_requests"))
+					&& sections_.count("render_settings")
+					&& sections_.count("routing_settings");
+			}
+
+			// True once everything but stat_requests has been read
+			bool HasBaseData() const {
+				return base_requests_done_
+					&& sections_.count("render_settings")
+					&& sections_.count("routing_settings");
+			}
+
+			const json::Node& GetSection(const std::string& key) const {
+				return sections_.at(key);
+			}
+
+		private:
+			enum class State {
+				ROOT,
+				SECTIONS,
+				BASE_REQUESTS,
+				STAT_REQUESTS,
+				DONE
+			};
+
+			std::function<void(const json::Node&)> on_base_request_;
+			StatRequestCallback on_stat_request_;
+			State state_ = State::ROOT;
+			bool forwarding_ = false;
+			bool has_base_requests_ = false;
+			bool base_requests_done_ = false;
+			bool has_stat_requests_ = false;
+			std::string key_;
+			json::TreeBuilder builder_;
+			std::map<std::string, json::Node> sections_;
+
+			// Streamed sections are handled as they are read, so a repeated
+			// one would add requests after the answers have been started
+			void CheckNotRepeated(bool has_section) const {
+				if (has_section) {
+					throw json::ParsingError("Duplicate key '" + key_ + "' have been found");
+				}
+			}
+
+			template <typename Event>
+			void Forward(Event event) {
+				if (state_ == State::ROOT || state_ == State::DONE) {
+					throw std::logic_error("incorrect input data");
+				}
+				forwarding_ = true;
+				event(builder_);
+				if (!builder_.IsComplete()) {
+					return;
+				}
+				forwarding_ = false;
+				if (state_ == State::BASE_REQUESTS) {
+					on_base_request_(builder_.Extract());
+				}
+				else if (state_ == State::STAT_REQUESTS) {
+					on_stat_request_(builder_.Extract(), *this);
+				}
+				else if (!sections_.emplace(key_, builder_.Extract()).second) {
+					throw json::ParsingError("Duplicate key '" + key_ + "' have been found");
+				}
+			}
+		};
+
+		// Splits the input into the four sections and base_requests into
+		// elements. Returns false for input that doesn't split into them:
+		// a broken document, a repeated, unknown or escaped key. Such input
+		// goes to ProcessRequests, so it is accepted or rejected the same
+		// way as without threads
+		bool SplitSections(std::string_view input, std::map<std::string_view, std::string_view>& sections,
+			std::vector<std::string_view>& base_requests) {
+			try {
+				for (const auto& [key, value] : json::SplitDict(input)) {
+					if (key != "base_requests" && key != "stat_requests"
+						&& key != "render_settings" && key != "routing_settings") {
+						return false;
+					}
+					if (!sections.emplace(key, value).second) {
+						return false;
+					}
+				}
+				if (sections.size() != 4) {
+					return false;
+				}
+				base_requests = json::SplitArray(sections.at("base_requests"));
+				return true;
+			}
+			catch (const json::ParsingError&) {
+				return false;
+			}
+		}
+
+	} // namespace
+
 	JSONReader::JSONReader(
 		TransportCatalogue& catalogue,
 		renderer::MapRenderer& map_renderer)
@@ -58,12 +266,190 @@ namespace catalogue {
 		return db_documents;
 	}
 
+	void JSONReader::ProcessRequests(std::istream& input, json::Writer& output) {
+		// the base data may have been loaded from a snapshot
+		const bool has_base_data = router_.has_value();
+		// stat requests that come before the data they need
+		std::vector<json::Node> postponed;
+
+		json::StreamBuilder answers(output);
+		answers.StartArray();
+
+		InputHandler handler({},
+			[this, has_base_data](const json::Node& request) {
+				if (has_base_data) {
+					throw std::logic_error("base data has already been read");
+				}
+				AddBaseRequest(request);
+			},
+			[&](const json::Node& request, const InputHandler& sections) {
+				if (!router_ && sections.HasBaseData()) {
+					BuildRouter(sections.GetSection("render_settings"), sections.GetSection("routing_settings"));
+				}
+				if (router_) {
+					GenerateAnswerToRequest(*router_, request, answers);
+				}
+				else {
+					postponed.push_back(request);
+				}
+			});
+		json::Parse(input, handler);
+
+		if (has_base_data) {
+			answers.EndArray().Finish();
+			return;
+		}
+		if (!handler.HasAllSections()) {
+			throw std::logic_error("incorrect input data");
+		}
+		if (!router_) {
+			BuildRouter(handler.GetSection("render_settings"), handler.GetSection("routing_settings"));
+		}
+		for (const json::Node& request : postponed) {
+			GenerateAnswerToRequest(*router_, request, answers);
+		}
+
+		answers.EndArray().Finish();
+	}
+
+	void JSONReader::ProcessRequestsInParallel(std::istream& input, json::Writer& output,
+		size_t threads) {
+		const std::string buffer = json::ReadAll(input);
+
+		std::map<std::string_view, std::string_view> sections;
+		std::vector<std::string_view> elements;
+		if (!SplitSections(buffer, sections, elements)) {
+			std::istringstream serial_input(buffer);
+			ProcessRequests(serial_input, output);
+			return;
+		}
+
+		// Elements are parsed in blocks, one TreeBuilder per block,
+		// and added to the catalogue in their original order
+		std::vector<json::Node> base_requests(elements.size());
+		const size_t block_count = (elements.size() + PARSE_BLOCK_SIZE - 1) / PARSE_BLOCK_SIZE;
+
+		ParallelFor(block_count, threads, [&](size_t block) {
+			json::TreeBuilder builder(std::pmr::get_default_resource(), buffer);
+			const size_t last = std::min(elements.size(), (block + 1) * PARSE_BLOCK_SIZE);
+			for (size_t i = block * PARSE_BLOCK_SIZE; i < last; ++i) {
+				json::Parse(elements[i], builder);
+				base_requests[i] = builder.Extract();
+			}
+		});
+
+		for (const json::Node& request : base_requests) {
+			AddBaseRequest(request);
+		}
+		base_requests.clear();
+
+		BuildRouter(json::Load(sections.at("render_settings")).GetRoot(),
+			json::Load(sections.at("routing_settings")).GetRoot());
+		GenerateAnswer(*router_, json::Load(sections.at("stat_requests")), output);
+	}
+
+	void JSONReader::ReadBaseData(std::istream& input) {
+		ReadBaseSections(input, [this](const json::Node& render_settings, const json::Node& routing_settings) {
+			BuildRouter(render_settings, routing_settings);
+		});
+	}
+
+	void JSONReader::ReadBaseSections(std::istream& input,
+		std::function<void(const json::Node& render_settings, const json::Node& routing_settings)> on_sections) {
+		InputHandler handler({},
+			[this](const json::Node& request) {
+				AddBaseRequest(request);
+			},
+			[](const json::Node&, const InputHandler&) {
+			});
+		json::Parse(input, handler);
+
+		if (!handler.HasBaseData()) {
+			throw std::logic_error("incorrect input data");
+		}
+		on_sections(handler.GetSection("render_settings"), handler.GetSection("routing_settings"));
+	}
+
+	// The settings go to the snapshot as compact JSON text: they are small,
+	// and CreateRenderSettings stays the only place that knows their format
+	void JSONReader::MakeBase(std::istream& input, const std::string& snapshot_path) {
+		ReadBaseSections(input, [&](const json::Node& render_settings, const json::Node& routing_settings) {
+			ApplyPendingBaseRequests();
+
+			snapshot::Writer writer;
+			catalogue_.Save(writer);
+			for (const json::Node* settings : { &render_settings, &routing_settings }) {
+				std::ostringstream text;
+				json::Writer settings_writer(text, json::Format::COMPACT);
+				settings_writer.Value(*settings);
+				settings_writer.Flush();
+				writer.Write(std::string_view(text.str()));
+			}
+			writer.Save(snapshot_path);
+		});
+	}
+
+	void JSONReader::SetRoutesFile(std::string routes_file) {
+		routes_file_ = std::move(routes_file);
+	}
+
+	void JSONReader::LoadBase(const std::string& snapshot_path) {
+		snapshot::Reader reader(snapshot_path);
+		catalogue_.Load(reader);
+		const json::Document render_settings = json::Load(reader.ReadText());
+		const json::Document routing_settings = json::Load(reader.ReadText());
+		if (!reader.AtEnd()) {
+			throw snapshot::SnapshotError("snapshot has more sections than expected");
+		}
+
+		BuildRouter(render_settings.GetRoot(), routing_settings.GetRoot());
+	}
+
+	void JSONReader::ProcessLineRequests(std::istream& input, json::Writer& output,
+		size_t flush_every) {
+		if (!router_) {
+			throw std::logic_error("base data has not been read");
+		}
+
+		size_t unflushed = 0;
+		std::string line;
+		while (std::getline(input, line)) {
+			if (line.find_first_not_of(" \t\r") == std::string::npos) {
+				continue;
+			}
+
+			const json::Document request = json::Load(std::string_view(line));
+			json::StreamBuilder answer(output);
+			GenerateAnswerToRequest(*router_, request.GetRoot(), answer);
+			answer.Finish();
+			output.EndLine();
+
+			if (++unflushed >= flush_every) {
+				output.Flush();
+				unflushed = 0;
+			}
+		}
+		output.Flush();
+	}
+
+	void JSONReader::BuildRouter(const json::Node& render_settings, const json::Node& routing_settings) {
+		ApplyPendingBaseRequests();
+		render_settings_ = CreateRenderSettings(render_settings.AsDict());
+		router_.emplace(catalogue_, CreateRoutingSettings(routing_settings));
+		if (routes_file_.empty()) {
+			router_->BuildGraphAndRouter();
+		}
+		else {
+			router_->BuildGraphAndRouter(routes_file_);
+		}
+	}
+
 	renderer::RenderSettings JSONReader::CreateRenderSettings(
 		const json::Node& settings_json) const {
 		if (settings_json.AsDict().empty()) {
 			return renderer::RenderSettings{};
 		}
-		std::map<std::string, json::Node> s = settings_json.AsDict();
+		const json::Dict& s = settings_json.AsDict();
 		renderer::RenderSettings settings;
 
 		settings.width = s.at("width").AsDouble();
@@ -84,11 +470,11 @@ namespace catalogue {
 		return settings;
 	}
 
-	svg::Color JSONReader::ReadUnderlayerColor(const std::map<std::string, json::Node>& s) const {
+	svg::Color JSONReader::ReadUnderlayerColor(const json::Dict& s) const {
 		svg::Color underlayer_color;
 
 		if (s.at("underlayer_color").IsString()) {
-			underlayer_color = s.at("underlayer_color").AsString();
+			underlayer_color = std::string(s.at("underlayer_color").AsString());
 		}
 		if (s.at("underlayer_color").IsArray()) {
 			if (s.at("underlayer_color").AsArray().size() == 3) {
@@ -110,7 +496,7 @@ namespace catalogue {
 		return underlayer_color;
 	}
 
-	std::vector<svg::Color> JSONReader::ReadColorPalette(const std::map<std::string, json::Node>& s) const {
+	std::vector<svg::Color> JSONReader::ReadColorPalette(const json::Dict& s) const {
 		std::vector<svg::Color> color_palette;
 		if (s.at("color_palette").AsArray().empty()) {
 			color_palette.push_back("none");
@@ -118,7 +504,7 @@ namespace catalogue {
 		else {
 			for (const auto& color : s.at("color_palette").AsArray()) {
 				if (color.IsString()) {
-					color_palette.push_back(color.AsString());
+					color_palette.push_back(std::string(color.AsString()));
 				}
 				else if (color.IsArray() && color.AsArray().size() == 3) {
 					uint8_t r, g, b;
@@ -142,10 +528,57 @@ namespace catalogue {
 	}
 
 	RoutingSettings JSONReader::CreateRoutingSettings(const json::Node& route_settings_node) const {
-		double bus_velocity = double(route_settings_node.AsDict().at("bus_velocity").AsInt()) * 1000 / 60;
-		double bus_wait_time = double(route_settings_node.AsDict().at("bus_wait_time").AsInt());
+		const json::Dict& settings = route_settings_node.AsDict();
+		double bus_velocity = double(settings.at("bus_velocity").AsInt()) * 1000 / 60;
+		double bus_wait_time = double(settings.at("bus_wait_time").AsInt());
+		RoutingSettings routing_settings{ bus_velocity, bus_wait_time };
+
+		// "engine": "all_pairs" (default), "dijkstra", "contraction_hierarchies",
+		// "a_star", "alt" or "raptor"
+		if (const auto it = settings.find("engine"); it != settings.end()) {
+			const std::string_view engine = it->second.AsString();
+			if (engine == "all_pairs") {
+				routing_settings.engine = RouterEngine::ALL_PAIRS;
+			}
+			else if (engine == "dijkstra") {
+				routing_settings.engine = RouterEngine::DIJKSTRA;
+			}
+			else if (engine == "contraction_hierarchies") {
+				routing_settings.engine = RouterEngine::CONTRACTION_HIERARCHIES;
+			}
+			else if (engine == "a_star") {
+				routing_settings.engine = RouterEngine::A_STAR;
+			}
+			else if (engine == "alt") {
+				routing_settings.engine = RouterEngine::ALT;
+			}
+			else if (engine == "raptor") {
+				routing_settings.engine = RouterEngine::RAPTOR;
+			}
+			else {
+				throw std::logic_error("unknown router engine: " + std::string(engine));
+			}
+		}
+		if (const auto it = settings.find("route_cache_size"); it != settings.end()) {
+			if (it->second.AsInt() < 0) {
+				throw std::logic_error("route_cache_size should be non-negative");
+			}
+			routing_settings.route_cache_size = static_cast<size_t>(it->second.AsInt());
+		}
+		if (const auto it = settings.find("landmark_count"); it != settings.end()) {
+			if (it->second.AsInt() < 0) {
+				throw std::logic_error("landmark_count should be non-negative");
+			}
+			routing_settings.landmark_count = static_cast<size_t>(it->second.AsInt());
+		}
+		if (const auto it = settings.find("build_threads"); it != settings.end()) {
+			if (it->second.AsInt() < 0) {
+				throw std::logic_error("build_threads should be non-negative");
+			}
+			routing_settings.build_threads = static_cast<size_t>(it->second.AsInt());
+		}
 
-		return RoutingSettings{ bus_velocity, bus_wait_time };
+		return routing_settings;
 	}
 
 	void JSONReader::BuildDataBase(const Data& data) {
@@ -172,8 +605,38 @@ namespace catalogue {
 
 
 
-	void JSONReader::AddNameAndCoordinatesOfStop(const json::Node& node) {
-		catalogue_.AddStop(
+	// Stops are added right away, distances and buses have to wait
+	// until every stop they refer to is known
+	void JSONReader::AddBaseRequest(const json::Node& request) {
+		if (!request.IsDict()) {
+			return;
+		}
+		if (request.AsDict().at("type") == "Stop") {
+			const StopId from = AddNameAndCoordinatesOfStop(request);
+			for (const auto& [to, distance] : request.AsDict().at("road_distances").AsDict()) {
+				pending_distances_.push_back({ from, std::string(to), distance.AsInt() });
+			}
+		}
+		else if (request.AsDict().at("type") == "Bus") {
+			pending_buses_.push_back(request);
+		}
+	}
+
+	void JSONReader::ApplyPendingBaseRequests() {
+		for (const auto& [from, to, distance] : pending_distances_) {
+			if (auto to_id = catalogue_.FindStop(to)) {
+				catalogue_.SetDistance(from, *to_id, distance);
+			}
+		}
+		for (const json::Node& bus_json : pending_buses_) {
+			AddJsonBus(bus_json);
+		}
+		pending_distances_.clear();
+		pending_buses_.clear();
+	}
+
+	StopId JSONReader::AddNameAndCoordinatesOfStop(const json::Node& node) {
+		return catalogue_.AddStop(
 			{
 			  node.AsDict().at("name").AsString(),
 			  node.AsDict().at("latitude").AsDouble(),
@@ -200,152 +663,200 @@ namespace catalogue {
 			: TypeRoute::DIRECT;
 
 		for (const json::Node& stop : node.AsDict().at("stops").AsArray()) {
-			bus.stops.push_back(catalogue_.FindStop(stop.AsString()));
+			bus.stops.push_back(catalogue_.FindStop(stop.AsString()).value());
+		}
+
+		if (bus.type_route == TypeRoute::DIRECT && !bus.stops.empty()) {
+			const size_t forward_size = bus.stops.size();
+			bus.stops.reserve(2 * forward_size - 1);
+			for (size_t n = forward_size - 1; n-- > 0;) {
+				bus.stops.push_back(bus.stops[n]);
+			}
 		}
 
-		if (bus.type_route == TypeRoute::DIRECT) {
-			std::deque<const Stop*> copy = bus.stops;
-			std::move(std::next(copy.rbegin()), copy.rend(), std::back_inserter(bus.stops));
+		if (const auto it = node.AsDict().find("timetable"); it != node.AsDict().end()) {
+			bus.departures = ReadDepartures(it->second.AsDict());
 		}
 
 		catalogue_.AddBus(bus);
 	}
 
-	json::Document JSONReader::GenerateAnswer(const TransportRouter& transport_router,
-		const json::Document& stat_requests) const {
-		std::vector<json::Node> answers;
-
-		for (const json::Node& request : stat_requests.GetRoot().AsArray()) {
-			if (request.AsDict().at("type") == "Bus") {
-				answers.push_back(std::move(GenerateAnswerBus(request)));
-			}
-			else if (request.AsDict().at("type") == "Stop") {
-				answers.push_back(std::move(GenerateAnswerStop(request)));
-			}
-			else if (request.AsDict().at("type") == "Route") {
-				answers.push_back(std::move(GenerateAnswerRoute(transport_router, request)));
+	// Times are in minutes from the start of the day. A timetable is either
+	// "departures": [...] or "first_departure", "last_departure" and "headway"
+	std::vector<double> JSONReader::ReadDepartures(const json::Dict& timetable) const {
+		std::vector<double> departures;
+		if (const auto it = timetable.find("departures"); it != timetable.end()) {
+			const json::Array& list = it->second.AsArray();
+			if (list.size() > MAX_TRIPS) {
+				throw std::logic_error("too many trips in timetable");
 			}
-			else {
-				answers.push_back(std::move(GenerateAnswerMap(request.AsDict().at("id").AsInt())));
+			for (const json::Node& departure : list) {
+				CheckDeparture(departure.AsDouble());
+				departures.push_back(departure.AsDouble());
 			}
+			std::sort(departures.begin(), departures.end());
+			return departures;
+		}
+
+		const double first = timetable.at("first_departure").AsDouble();
+		const double last = timetable.at("last_departure").AsDouble();
+		const double headway = timetable.at("headway").AsDouble();
+		CheckDeparture(first);
+		CheckDeparture(last);
+		if (!(headway > 0)) {
+			throw std::logic_error("headway should be positive");
 		}
-		return json::Document{ answers };
+		if (last < first) {
+			return departures;
+		}
+		// Counting trips rather than adding up the headway keeps the last
+		// departure exact
+		const double trip_count = std::floor((last - first) / headway) + 1;
+		if (trip_count > MAX_TRIPS) {
+			throw std::logic_error("too many trips in timetable");
+		}
+		for (size_t trip = 0; trip < static_cast<size_t>(trip_count) && first + trip * headway <= last; ++trip) {
+			departures.push_back(first + trip * headway);
+		}
+		return departures;
 	}
 
-	json::Node JSONReader::GenerateAnswerBus(const json::Node& request) const {
-		std::string_view bus_name = request.AsDict().at("name").AsString();
-		json::Builder answer;
-		answer.StartDict().Key("request_id").Value(request.AsDict().at("id").AsInt());
-		
-		const BusInfo bus_info = std::move(catalogue_.GetBusInfo(bus_name));
-		
-		if (catalogue_.FindBus(bus_name)) {
-			answer.Key("curvature").Value(bus_info.curvature)
-				.Key("route_length").Value(bus_info.length_route)
-				.Key("stop_count").Value(static_cast<int>(bus_info.number_stops))
-				.Key("unique_stop_count").Value(static_cast<int>(bus_info.unique_stops))
-			.EndDict();
+	void JSONReader::GenerateAnswer(const TransportRouter& transport_router,
+		const json::Document& stat_requests, json::Writer& output) const {
+		json::StreamBuilder answers(output);
+		answers.StartArray();
+
+		for (const json::Node& request : stat_requests.GetRoot().AsArray()) {
+			GenerateAnswerToRequest(transport_router, request, answers);
+		}
+
+		answers.EndArray().Finish();
+	}
+
+	void JSONReader::GenerateAnswerToRequest(const TransportRouter& transport_router,
+		const json::Node& request, json::StreamBuilder& answer) const {
+		if (request.AsDict().at("type") == "Bus") {
+			GenerateAnswerBus(request, answer);
+		}
+		else if (request.AsDict().at("type") == "Stop") {
+			GenerateAnswerStop(request, answer);
+		}
+		else if (request.AsDict().at("type") == "Route") {
+			GenerateAnswerRoute(transport_router, request, answer);
 		}
 		else {
-			answer.Key("error_message").Value("not found").EndDict();
+			GenerateAnswerMap(request.AsDict().at("id").AsInt(), answer);
+		}
+	}
+
+	// Keys of the answers go in alphabetical order, the way json::Dict prints them
+
+	void JSONReader::GenerateAnswerBus(const json::Node& request, json::StreamBuilder& answer) const {
+		std::string_view bus_name = request.AsDict().at("name").AsString();
+		const int id = request.AsDict().at("id").AsInt();
+
+		if (!catalogue_.FindBus(bus_name)) {
+			answer.StartDict()
+				.Key("error_message").Value("not found")
+				.Key("request_id").Value(id)
+			.EndDict();
+			return;
 		}
 
-		return answer.Build();
+		const BusInfo bus_info = catalogue_.GetBusInfo(bus_name);
+		answer.StartDict()
+			.Key("curvature").Value(bus_info.curvature)
+			.Key("request_id").Value(id)
+			.Key("route_length").Value(bus_info.length_route)
+			.Key("stop_count").Value(static_cast<int>(bus_info.number_stops))
+			.Key("unique_stop_count").Value(static_cast<int>(bus_info.unique_stops))
+		.EndDict();
 	}
 
-	json::Node JSONReader::GenerateAnswerStop(const json::Node& request) const {
+	void JSONReader::GenerateAnswerStop(const json::Node& request, json::StreamBuilder& answer) const {
 		std::string_view stop_name = request.AsDict().at("name").AsString();
-		json::Builder answer;
-		answer.StartDict().Key("request_id").Value(request.AsDict().at("id").AsInt());
-		if (catalogue_.FindStop(stop_name)) {
-			answer.Key("buses").StartArray();
-
-			std::vector<json::Node> buses;
-			for (const auto& bus : catalogue_.GetStopInfo(stop_name).buses) {
-				buses.push_back(bus->name);
-			}
-			std::sort(buses.begin(), buses.end(), [&](const json::Node& l, const json::Node& r) {
-				return std::lexicographical_compare(l.AsString().begin(), l.AsString().end(),
-					r.AsString().begin(), r.AsString().end());
-				}
-			);
-			// Add sorted array
-			for (const auto& bus : buses) {
-				answer.Value(bus.AsString());
-			}
-			answer.EndArray();
-		}
-		else {
-			answer.Key("error_message").Value("not found");
+		const int id = request.AsDict().at("id").AsInt();
+
+		const auto stop = catalogue_.FindStop(stop_name);
+		if (!stop) {
+			answer.StartDict()
+				.Key("error_message").Value("not found")
+				.Key("request_id").Value(id)
+			.EndDict();
+			return;
 		}
-		answer.EndDict();
 
-		return answer.Build();
+		answer.StartDict().Key("buses").StartArray();
+		for (BusId bus : catalogue_.GetBusesByStop(*stop)) {
+			answer.Value(catalogue_.GetBusName(bus));
+		}
+		answer.EndArray()
+			.Key("request_id").Value(id)
+		.EndDict();
 	}
 
-	json::Node JSONReader::GenerateAnswerRoute(const TransportRouter& router,
-		const json::Node& request) const {
-		
+	void JSONReader::GenerateAnswerRoute(const TransportRouter& router,
+		const json::Node& request, json::StreamBuilder& answer) const {
+		const int id = request.AsDict().at("id").AsInt();
+
+		// "departure_time" in minutes from the start of the day
+		std::optional<double> departure_time;
+		if (const auto it = request.AsDict().find("departure_time"); it != request.AsDict().end()) {
+			departure_time = it->second.AsDouble();
+			CheckDeparture(*departure_time);
+		}
 		auto route_info = router.BuildRoute(request.AsDict().at("from").AsString(),
-											request.AsDict().at("to").AsString());
+											request.AsDict().at("to").AsString(), departure_time);
 		if (!route_info) {
-			return json::Builder{}.StartDict().
-				Key("request_id").Value(request.AsDict().at("id").AsInt()).
-				Key("error_message").Value("not found")
-			.EndDict().Build();
+			answer.StartDict()
+				.Key("error_message").Value("not found")
+				.Key("request_id").Value(id)
+			.EndDict();
+			return;
 		}
 
-		json::Array items;
-		for (const auto& edge_id : route_info->edges) {
-			items.emplace_back(ConvertEdgeInfo(router, edge_id));
+		answer.StartDict().Key("items").StartArray();
+		for (const EdgeInfo& item : route_info->items) {
+			ConvertEdgeInfo(item, answer);
 		}
-
-		return json::Builder{}.StartDict()
-			.Key("request_id").Value(request.AsDict().at("id").AsInt())
-			.Key("total_time").Value(route_info->weight)
-			.Key("items").Value(items)
-		.EndDict().Build();
+		answer.EndArray()
+			.Key("request_id").Value(id)
+			.Key("total_time").Value(route_info->total_time)
+		.EndDict();
 	}
 
-	json::Node JSONReader::ConvertEdgeInfo(const TransportRouter& router, const EdgeId edge_id) const {
+	void JSONReader::ConvertEdgeInfo(const EdgeInfo& item, json::StreamBuilder& answer) const {
 
-		if (std::holds_alternative<EdgeBusInfo>(router.GetEdgeInfo(edge_id))) {
-			const EdgeBusInfo edge_info = std::get<EdgeBusInfo>(router.GetEdgeInfo(edge_id));
+		if (std::holds_alternative<EdgeBusInfo>(item)) {
+			const EdgeBusInfo edge_info = std::get<EdgeBusInfo>(item);
 
-			return json::Builder{}.StartDict()
-				.Key("type").Value("Bus")
-				.Key("bus").Value(std::string(edge_info.bus->name))
+			answer.StartDict()
+				.Key("bus").Value(catalogue_.GetBusName(edge_info.bus))
 				.Key("span_count").Value(static_cast<int>(edge_info.span_count))
 				.Key("time").Value(edge_info.weight)
-			.EndDict().Build();
+				.Key("type").Value("Bus")
+			.EndDict();
+			return;
 		}
 
-		const EdgeWaitInfo edge_info = std::get<EdgeWaitInfo>(router.GetEdgeInfo(edge_id));
+		const EdgeWaitInfo edge_info = std::get<EdgeWaitInfo>(item);
 
-		return json::Builder{}.StartDict()
-			.Key("type").Value("Wait")
-			.Key("stop_name").Value(std::string(edge_info.stop->name))
+		answer.StartDict()
+			.Key("stop_name").Value(catalogue_.GetStopName(edge_info.stop))
 			.Key("time").Value(edge_info.weight)
-		.EndDict().Build();
+			.Key("type").Value("Wait")
+		.EndDict();
 	}
 
-	json::Node JSONReader::GenerateAnswerMap(const int id) const {
+	void JSONReader::GenerateAnswerMap(const int id, json::StreamBuilder& answer) const {
 		std::ostringstream output;
 
-		std::set< const Bus*, CompareBuses > buses;
-		for (const Bus* bus_ptr : catalogue_.GetAllBuses()) {
-			buses.insert(bus_ptr);
-		}
-
-		map_renderer_.RenderMap(render_settings_, buses).Render(output);
+		map_renderer_.RenderMap(render_settings_, catalogue_.GetAllBuses()).Render(output);
 
-		json::Builder answer;
 		answer.StartDict()
-			.Key("request_id").Value(id)
 			.Key("map").Value(output.str())
-			.EndDict();
-
-		return answer.Build();
+			.Key("request_id").Value(id)
+		.EndDict();
 	}
 
 } // namespace catalogue
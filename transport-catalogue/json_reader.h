@@ -2,13 +2,19 @@
 
 #include "domain.h"
 #include "json.h"
+#include "json_builder.h"
 #include "transport_catalogue.h"
 #include "request_handler.h"
 #include "map_renderer.h"
 #include "router.h"
 #include "transport_router.h"
 
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
 #include <variant>
+#include <vector>
 
 namespace catalogue {
 
@@ -30,30 +36,84 @@ namespace catalogue {
 
 		void BuildDataBase(const Data& data);
 
-		json::Document GenerateAnswer(const TransportRouter& transport_router,
-									  const json::Document& stat_requests) const;
+		// Reads the input element by element and answers every stat request
+		// as soon as it is read, so memory does not grow with the number of
+		// requests. Requests that come before the base data are kept until it
+		// has been read
+		void ProcessRequests(std::istream& input, json::Writer& output);
+
+		// Reads the whole input into memory and parses the elements of
+		// base_requests on threads threads (0 means one per core). Answers are
+		// written after the catalogue and the router are built
+		void ProcessRequestsInParallel(std::istream& input, json::Writer& output, size_t threads);
+
+		// Reads base_requests, render_settings and routing_settings and builds
+		// the router. stat_requests, if present, is skipped
+		void ReadBaseData(std::istream& input);
+
+		// Reads base_requests, render_settings and routing_settings like
+		// ReadBaseData and saves the catalogue and the settings to a snapshot
+		// file instead of building the router
+		void MakeBase(std::istream& input, const std::string& snapshot_path);
+
+		// Restores the catalogue and the settings from a snapshot made by
+		// MakeBase and builds the router. The input of ProcessRequests then
+		// needs only stat_requests
+		void LoadBase(const std::string& snapshot_path);
+
+		// The router keeps its graph and routes in routes_file between runs,
+		// see TransportRouter::BuildGraphAndRouter
+		void SetRoutesFile(std::string routes_file);
+
+		// Answers one JSON request per line, one answer per line, until the end
+		// of input. The output is flushed after every flush_every answers.
+		// ReadBaseData has to be called first
+		void ProcessLineRequests(std::istream& input, json::Writer& output, size_t flush_every = 1);
+
+		// Writes the answers as a JSON array; each answer goes to the output
+		// as soon as it is ready
+		void GenerateAnswer(const TransportRouter& transport_router,
+							const json::Document& stat_requests, json::Writer& output) const;
 
 	private:
+		struct PendingDistance {
+			StopId from;
+			std::string to;
+			int distance;
+		};
+
 		TransportCatalogue& catalogue_;
 		renderer::MapRenderer& map_renderer_;
 		renderer::RenderSettings render_settings_;
+		std::vector<PendingDistance> pending_distances_;
+		std::vector<json::Node> pending_buses_;
+		std::optional<TransportRouter> router_;
+		std::string routes_file_;
 
-		svg::Color ReadUnderlayerColor(const std::map<std::string, json::Node>& s) const;
-		std::vector<svg::Color> ReadColorPalette(const std::map<std::string, json::Node>& s) const;
+		svg::Color ReadUnderlayerColor(const json::Dict& s) const;
+		std::vector<svg::Color> ReadColorPalette(const json::Dict& s) const;
 		renderer::RenderSettings CreateRenderSettings(const json::Node& settings) const;
 		RoutingSettings CreateRoutingSettings(const json::Node& input_node) const;
 
-		void AddNameAndCoordinatesOfStop(const json::Node& node);
+		void BuildRouter(const json::Node& render_settings, const json::Node& routing_settings);
+		void ReadBaseSections(std::istream& input,
+			std::function<void(const json::Node& render_settings, const json::Node& routing_settings)> on_sections);
+		void AddBaseRequest(const json::Node& request);
+		void ApplyPendingBaseRequests();
+		StopId AddNameAndCoordinatesOfStop(const json::Node& node);
 		void AddDistanceBetweenStops(const json::Node& stop_from);
 		void AddJsonBus(const json::Node& node);
+		std::vector<double> ReadDepartures(const json::Dict& timetable) const;
 
-		json::Node GenerateAnswerBus(const json::Node& request) const;
-		json::Node GenerateAnswerStop(const json::Node& request) const;
-		json::Node GenerateAnswerMap(const int id) const;
-		json::Node GenerateAnswerRoute(const TransportRouter& router,	
-			const json::Node& request) const;
+		void GenerateAnswerToRequest(const TransportRouter& transport_router,
+			const json::Node& request, json::StreamBuilder& answer) const;
+		void GenerateAnswerBus(const json::Node& request, json::StreamBuilder& answer) const;
+		void GenerateAnswerStop(const json::Node& request, json::StreamBuilder& answer) const;
+		void GenerateAnswerMap(const int id, json::StreamBuilder& answer) const;
+		void GenerateAnswerRoute(const TransportRouter& router,
+			const json::Node& request, json::StreamBuilder& answer) const;
 
-		json::Node ConvertEdgeInfo(const TransportRouter& router, const EdgeId edge_id) const;
+		void ConvertEdgeInfo(const EdgeInfo& item, json::StreamBuilder& answer) const;
 	};
 
 } // namespace catalogue
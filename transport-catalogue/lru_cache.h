@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace catalogue {
+
+	// Keeps the capacity most recently used values. A cache of capacity 0
+	// keeps nothing
+	template <typename Key, typename Value>
+	class LruCache {
+	public:
+		explicit LruCache(size_t capacity)
+			: capacity_(capacity) {
+		}
+
+		// nullptr if there is no value for key. A found value becomes the
+		// most recently used one
+		const Value* Find(const Key& key) {
+			const auto it = index_.find(key);
+			if (it == index_.end()) {
+				return nullptr;
+			}
+			items_.splice(items_.begin(), items_, it->second);
+			return &it->second->second;
+		}
+
+		void Insert(const Key& key, Value value) {
+			if (capacity_ == 0) {
+				return;
+			}
+			if (const auto it = index_.find(key); it != index_.end()) {
+				it->second->second = std::move(value);
+				items_.splice(items_.begin(), items_, it->second);
+				return;
+			}
+			if (items_.size() == capacity_) {
+				index_.erase(items_.back().first);
+				items_.pop_back();
+			}
+			items_.emplace_front(key, std::move(value));
+			index_.emplace(key, items_.begin());
+		}
+
+	private:
+		size_t capacity_;
+		// The most recently used values come first
+		std::list<std::pair<Key, Value>> items_;
+		std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator> index_;
+	};
+
+} // namespace catalogue
@@ -4,21 +4,144 @@
 #include "request_handler.h"
 #include "transport_router.h"
 
-int main() {
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+// Options:
+//   --compact          print the answers without indentation
+//   --ndjson           answer one request per line; the base document is
+//                      the first line of input unless --base is given
+//   --base FILE        with --ndjson, read base_requests and the settings
+//                      from FILE
+//   --flush-every N    in --ndjson mode flush the output after N answers
+//   --threads N        read the whole input and parse base_requests on N
+//                      threads, 0 means one per core; not with --ndjson
+//   --make-base FILE   read base_requests and the settings, save them to the
+//                      snapshot FILE and exit without answering requests
+//   --snapshot FILE    take the base data from the snapshot FILE; the input
+//                      holds only stat_requests (or only request lines with
+//                      --ndjson)
+//   --routes FILE      keep the router's graph and routes in FILE; they are
+//                      rebuilt when FILE was made for other base data
+int main(int argc, char* argv[]) {
+	using namespace std::literals;
+
+	json::Format format = json::Format::PRETTY;
+	bool ndjson = false;
+	std::string base_file;
+	size_t flush_every = 1;
+	std::optional<size_t> threads;
+	std::string make_base_file;
+	std::string snapshot_file;
+	std::string routes_file;
+
+	for (int i = 1; i < argc; ++i) {
+		const std::string_view arg = argv[i];
+		if (arg == "--compact"sv) {
+			format = json::Format::COMPACT;
+		}
+		else if (arg == "--ndjson"sv) {
+			ndjson = true;
+		}
+		else if (arg == "--base"sv && i + 1 < argc) {
+			base_file = argv[++i];
+		}
+		else if (arg == "--flush-every"sv && i + 1 < argc) {
+			flush_every = std::max<size_t>(std::strtoul(argv[++i], nullptr, 10), 1);
+		}
+		else if (arg == "--threads"sv && i + 1 < argc) {
+			threads = std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (arg == "--make-base"sv && i + 1 < argc) {
+			make_base_file = argv[++i];
+		}
+		else if (arg == "--snapshot"sv && i + 1 < argc) {
+			snapshot_file = argv[++i];
+		}
+		else if (arg == "--routes"sv && i + 1 < argc) {
+			routes_file = argv[++i];
+		}
+		else {
+			std::cerr << "Unknown option: "sv << arg << std::endl;
+			return 1;
+		}
+	}
+
+	if (ndjson && threads) {
+		std::cerr << "--threads can't be combined with --ndjson"sv << std::endl;
+		return 1;
+	}
+	if (!ndjson && !base_file.empty()) {
+		std::cerr << "--base needs --ndjson"sv << std::endl;
+		return 1;
+	}
+
 	catalogue::TransportCatalogue catalogue;
-	catalogue::renderer::MapRenderer map_renderer;
+	catalogue::renderer::MapRenderer map_renderer(catalogue);
 	catalogue::JSONReader json_reader(catalogue, map_renderer);
+	json_reader.SetRoutesFile(routes_file);
+
+	if (!make_base_file.empty()) {
+		try {
+			json_reader.MakeBase(std::cin, make_base_file);
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Can't make snapshot "sv << make_base_file << ": "sv << e.what() << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+	if (!snapshot_file.empty()) {
+		if (threads || !base_file.empty()) {
+			std::cerr << "--snapshot can't be combined with --threads or --base"sv << std::endl;
+			return 1;
+		}
+		// The input holds no base data to rebuild from, so a snapshot that
+		// can't be loaded leaves nothing to answer with
+		try {
+			json_reader.LoadBase(snapshot_file);
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Can't load snapshot "sv << snapshot_file << ": "sv << e.what() << std::endl;
+			return 1;
+		}
+	}
+
+	if (!ndjson) {
+		json::Writer output(std::cout, format);
+		if (threads) {
+			json_reader.ProcessRequestsInParallel(std::cin, output, *threads);
+		}
+		else {
+			json_reader.ProcessRequests(std::cin, output);
+		}
+		return 0;
+	}
 
-	catalogue::Data data = std::move(json_reader.ReadJSON(std::cin));
+	if (!base_file.empty()) {
+		std::ifstream base(base_file, std::ios::binary);
+		if (!base) {
+			std::cerr << "Can't open "sv << base_file << std::endl;
+			return 1;
+		}
+		json_reader.ReadBaseData(base);
+	}
+	else if (snapshot_file.empty()) {
+		std::string line;
+		std::getline(std::cin, line);
+		std::istringstream base(line);
+		json_reader.ReadBaseData(base);
+	}
 
-	catalogue::TransportRouter transport_router(catalogue, data.routing_settings);
-	catalogue::RequestHandler request_handler(catalogue, map_renderer, transport_router);
-	
-	json_reader.BuildDataBase(data);
-	transport_router.BuildGraphAndRouter();
+	json::Writer output(std::cout, json::Format::COMPACT);
+	json_reader.ProcessLineRequests(std::cin, output, flush_every);
 
-	json::Document answers = std::move(json_reader.GenerateAnswer(transport_router, data.stat_requests));
-	json::Print(answers, std::cout);
-	
 	return 0;
 }
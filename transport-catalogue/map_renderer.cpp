@@ -1,6 +1,5 @@
 #include "map_renderer.h"
 
-#include <map>
 #include <string_view>
 #include <algorithm>
 
@@ -20,8 +19,12 @@ namespace catalogue {
             };
         }
 
+        MapRenderer::MapRenderer(const TransportCatalogue& catalogue)
+            : catalogue_(catalogue) {
+        }
+
         svg::Document MapRenderer::RenderMap(const renderer::RenderSettings& render_settings,
-                                             const std::set< const Bus*, CompareBuses >& buses) const {
+                                             IdSpan<BusId> buses) const {
             // 1. upload all routes and coordinates of stops 
             //    that are included in these routes
             auto [map_buses_to_geo_coords_of_stops, all_geo_coords] =
@@ -43,24 +46,25 @@ namespace catalogue {
 
         std::pair<BusesCoordinates, std::vector<geo::Coordinates>> 
             MapRenderer::HighlightBusesAndCoordinatesOfStops(
-                const std::set< const Bus*, CompareBuses >& buses) const {
+                IdSpan<BusId> buses) const {
 
             BusesCoordinates bus_geo_coords; // BusesCoordinates defind in MapRenderer.h
+            bus_geo_coords.reserve(buses.size());
             std::vector<geo::Coordinates> all_geo_coords;
-            for (const Bus* bus : buses) {
+            for (BusId bus : buses) {
                 std::vector<geo::Coordinates> geo_coords;
-                for (const auto& stop : bus->stops) {
-                    geo_coords.push_back({ stop->coordinate.lat, stop->coordinate.lng });
-                    all_geo_coords.push_back({ stop->coordinate.lat, stop->coordinate.lng });
+                for (StopId stop : catalogue_.GetBusStops(bus)) {
+                    geo_coords.push_back(catalogue_.GetStopCoordinates(stop));
+                    all_geo_coords.push_back(catalogue_.GetStopCoordinates(stop));
                 }
-                bus_geo_coords.insert({ bus, std::move(geo_coords) });
+                bus_geo_coords.push_back(std::move(geo_coords));
             }
 
             return std::pair{ bus_geo_coords, all_geo_coords };
         }
 
         svg::Document MapRenderer::CreateVisualization(const renderer::RenderSettings& render_settings, 
-                                                       const std::set< const Bus*, CompareBuses >& buses,
+                                                       IdSpan<BusId> buses,
                                                        const BusesCoordinates& bus_geo_coords,
                                                        const SphereProjector proj) const {
             // 1.
@@ -68,11 +72,17 @@ namespace catalogue {
             // 2.
             CreateRouteNames(render_settings, buses, document, proj);
 
-            // collecting all stops
-            std::set<const Stop*, CompareStop> stops;
-            for (const Bus* bus : buses) {
-                for (const Stop* stop : bus->stops) {
-                    stops.insert(stop);
+            // collecting all stops; the catalogue already keeps them sorted by name
+            std::vector<bool> is_on_route(catalogue_.GetStopCount());
+            for (BusId bus : buses) {
+                for (StopId stop : catalogue_.GetBusStops(bus)) {
+                    is_on_route[stop] = true;
+                }
+            }
+            std::vector<StopId> stops;
+            for (StopId stop : catalogue_.GetAllStops()) {
+                if (is_on_route[stop]) {
+                    stops.push_back(stop);
                 }
             }
             // 3.
@@ -89,8 +99,8 @@ namespace catalogue {
             svg::Document document;
 
             size_t count = 0;
-            for (const auto& [bus, geo_coords] : bus_geo_coords) {
-                if (bus->stops.empty()) {
+            for (const auto& geo_coords : bus_geo_coords) {
+                if (geo_coords.empty()) {
                     continue;
                 }
                 svg::Polyline polyline;
@@ -117,27 +127,27 @@ namespace catalogue {
         }
 
         void MapRenderer::CreateRouteNames(const renderer::RenderSettings& render_settings
-                                          , const std::set< const Bus*, CompareBuses >& buses
+                                          , IdSpan<BusId> buses
                                           , svg::Document& document, const SphereProjector proj) const {
             size_t count = 0;
-            for (const Bus* bus : buses) {
-                if (bus->stops.empty()) {
+            for (BusId bus : buses) {
+                const IdSpan<StopId> stops = catalogue_.GetBusStops(bus);
+                if (stops.empty()) {
                     continue;
                 }
-                geo::Coordinates route_begin = { bus->stops[0]->coordinate.lat, 
-                                                 bus->stops[0]->coordinate.lng };
-                geo::Coordinates route_end = { bus->stops[(bus->stops.size())/2]->coordinate.lat,
-                                               bus->stops[(bus->stops.size())/2]->coordinate.lng };
+                const std::string_view bus_name = catalogue_.GetBusName(bus);
+                geo::Coordinates route_begin = catalogue_.GetStopCoordinates(stops[0]);
+                geo::Coordinates route_end = catalogue_.GetStopCoordinates(stops[stops.size() / 2]);
                 auto [background_begin, title_begin] = std::move(
                     CreateBackgroundAndTitleForRoute(
-                        render_settings, proj(route_begin), bus->name, count)
+                        render_settings, proj(route_begin), bus_name, count)
                 );
                 document.Add(background_begin);
                 document.Add(title_begin);
-                if (bus->type_route == TypeRoute::DIRECT && route_begin != route_end) {
+                if (catalogue_.GetBusType(bus) == TypeRoute::DIRECT && route_begin != route_end) {
                     auto [background_end, title_end] = std::move(
                         CreateBackgroundAndTitleForRoute(
-                            render_settings, proj(route_end), bus->name, count)
+                            render_settings, proj(route_end), bus_name, count)
                     );
                     document.Add(background_end);
                     document.Add(title_end);
@@ -181,42 +191,43 @@ namespace catalogue {
 
         void MapRenderer::CreateStopIcons(const renderer::RenderSettings& render_settings 
                                          ,  svg::Document& document
-                                         , const std::set<const Stop*, CompareStop>& stops
+                                         , const std::vector<StopId>& stops
                                          , const SphereProjector proj) const {
             svg::Circle circle;
             // creating default settings for all stops
             circle.SetRadius(render_settings.stop_radius).SetFillColor("white");
             // create stop icons
-            for (const Stop* stop : stops) {
-                circle.SetCenter(proj({ stop->coordinate.lat, stop->coordinate.lng }));
+            for (StopId stop : stops) {
+                circle.SetCenter(proj(catalogue_.GetStopCoordinates(stop)));
                 document.Add(circle);
             }
         }
 
         void MapRenderer::CreateStopNames(const renderer::RenderSettings& render_settings
                                          , svg::Document& document
-                                         , const std::set<const Stop*, CompareStop>& stops
+                                         , const std::vector<StopId>& stops
                                          , const SphereProjector proj) const {
             svg::Text background;
             svg::Text title;
-            for (const Stop* stop : stops) {
-                background.SetPosition(proj({ stop->coordinate.lat, stop->coordinate.lng }))
+            for (StopId stop : stops) {
+                const svg::Point point = proj(catalogue_.GetStopCoordinates(stop));
+                background.SetPosition(point)
                     .SetOffset({ render_settings.stop_label_offset[0],
                                  render_settings.stop_label_offset[1] })
                     .SetFontSize(render_settings.stop_label_font_size)
                     .SetFontFamily("Verdana")
-                    .SetData(stop->name)
+                    .SetData(std::string(catalogue_.GetStopName(stop)))
                     .SetFillColor(render_settings.underlayer_color)
                     .SetStrokeColor(render_settings.underlayer_color)
                     .SetStrokeWidth(render_settings.underlayer_width)
                     .SetStrokeLineCap(svg::StrokeLineCap::ROUND)
                     .SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-                title.SetPosition(proj({ stop->coordinate.lat, stop->coordinate.lng }))
+                title.SetPosition(point)
                     .SetOffset({ render_settings.stop_label_offset[0],
                                  render_settings.stop_label_offset[1] })
                     .SetFontSize(render_settings.stop_label_font_size)
                     .SetFontFamily("Verdana")
-                    .SetData(stop->name)
+                    .SetData(std::string(catalogue_.GetStopName(stop)))
                     .SetFillColor("black");
                 document.Add(background);
                 document.Add(title);
@@ -3,10 +3,9 @@
 #include "geo.h"
 #include "svg.h"
 #include "domain.h"
+#include "transport_catalogue.h"
 
 #include <vector>
-#include <set>
-#include <map>
 #include <string_view>
 
 namespace catalogue {
@@ -53,20 +52,27 @@ namespace catalogue {
             double zoom_coeff_ = 0;
         };
 
-        using BusesCoordinates = std::map<const Bus*, std::vector<geo::Coordinates>, CompareBuses>;
+        // Координаты остановок каждого маршрута в порядке списка маршрутов
+        using BusesCoordinates = std::vector<std::vector<geo::Coordinates>>;
 
         class MapRenderer {
         public:
+            explicit MapRenderer(const TransportCatalogue& catalogue);
+
+            // buses должны быть упорядочены по названию, как в
+            // TransportCatalogue::GetAllBuses
             svg::Document RenderMap(const renderer::RenderSettings& render_settings,
-                                    const std::set< const Bus*, CompareBuses >& buses) const;
+                                    IdSpan<BusId> buses) const;
 
         private:
+            const TransportCatalogue& catalogue_;
+
             std::pair<BusesCoordinates, std::vector<geo::Coordinates>>
                 HighlightBusesAndCoordinatesOfStops(
-                    const std::set< const Bus*, CompareBuses >& buses) const;
+                    IdSpan<BusId> buses) const;
 
             svg::Document CreateVisualization(const renderer::RenderSettings& render_settings, 
-                                              const std::set< const Bus*, CompareBuses >& buses,
+                                              IdSpan<BusId> buses,
                                               const BusesCoordinates& bus_geo_coords,
                                               const SphereProjector proj) const;
 
@@ -78,7 +84,7 @@ namespace catalogue {
                                                 svg::Polyline& polyline, size_t count) const;
 
             void CreateRouteNames(const renderer::RenderSettings& render_settings
-                                 , const std::set< const Bus*, CompareBuses >& buses
+                                 , IdSpan<BusId> buses
                                  , svg::Document& document, const SphereProjector proj) const;
 
             std::pair<svg::Text, svg::Text> CreateBackgroundAndTitleForRoute(
@@ -87,12 +93,12 @@ namespace catalogue {
 
             void CreateStopIcons(const renderer::RenderSettings& render_settings
                                 , svg::Document& document
-                                , const std::set<const Stop*, CompareStop>& stops
+                                , const std::vector<StopId>& stops
                                 , const SphereProjector proj) const;
 
             void CreateStopNames(const renderer::RenderSettings& render_settings
                                 , svg::Document& document
-                                , const std::set<const Stop*, CompareStop>& stops
+                                , const std::vector<StopId>& stops
                                 , const SphereProjector proj) const;
         };
 
@@ -0,0 +1,112 @@
+#include "name_pool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace catalogue {
+
+	std::pair<NamePool::Id, bool> NamePool::Intern(std::string_view name) {
+		const uint64_t hash = Hash(name);
+		if (!slots_.empty()) {
+			const Id id = slots_[FindSlot(name, hash)];
+			if (id != EMPTY_SLOT) {
+				return { id, false };
+			}
+		}
+
+		if (arena_.size() + name.size() >= UINT32_MAX || Size() + 1 >= EMPTY_SLOT) {
+			throw std::length_error("too many names");
+		}
+		// the table is kept at most half full
+		if (2 * (Size() + 1) > slots_.size()) {
+			Rehash(std::max<size_t>(16, 2 * slots_.size()));
+		}
+
+		const Id id = static_cast<Id>(Size());
+		arena_.append(name);
+		offsets_.push_back(static_cast<uint32_t>(arena_.size()));
+		hashes_.push_back(hash);
+		slots_[FindSlot(name, hash)] = id;
+
+		return { id, true };
+	}
+
+	std::optional<NamePool::Id> NamePool::Find(std::string_view name) const {
+		if (slots_.empty()) {
+			return std::nullopt;
+		}
+		const Id id = slots_[FindSlot(name, Hash(name))];
+		if (id == EMPTY_SLOT) {
+			return std::nullopt;
+		}
+		return id;
+	}
+
+	std::string_view NamePool::Get(Id id) const {
+		return std::string_view(arena_).substr(offsets_.at(id), offsets_.at(id + 1) - offsets_[id]);
+	}
+
+	size_t NamePool::Size() const {
+		return hashes_.size();
+	}
+
+	// FNV-1a
+	uint64_t NamePool::Hash(std::string_view name) {
+		uint64_t hash = 0xcbf29ce484222325ULL;
+		for (char c : name) {
+			hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3ULL;
+		}
+		return hash;
+	}
+
+	// The slot that holds name or the empty slot where it would go
+	size_t NamePool::FindSlot(std::string_view name, uint64_t hash) const {
+		const size_t mask = slots_.size() - 1;
+		for (size_t index = hash & mask; ; index = (index + 1) & mask) {
+			const Id id = slots_[index];
+			if (id == EMPTY_SLOT || (hashes_[id] == hash && Get(id) == name)) {
+				return index;
+			}
+		}
+	}
+
+	void NamePool::Save(snapshot::Writer& writer) const {
+		writer.Write(std::string_view(arena_));
+		writer.Write(offsets_);
+		writer.Write(hashes_);
+		writer.Write(slots_);
+	}
+
+	void NamePool::Load(snapshot::Reader& reader) {
+		arena_ = reader.ReadText();
+		reader.Read(offsets_);
+		reader.Read(hashes_);
+		reader.Read(slots_);
+
+		// The table is empty only until the first name is added
+		const bool is_valid_capacity = slots_.empty()
+			? hashes_.empty()
+			: (slots_.size() & (slots_.size() - 1)) == 0 && 2 * hashes_.size() <= slots_.size();
+		if (offsets_.size() != hashes_.size() + 1 || offsets_.front() != 0 || offsets_.back() != arena_.size()
+			|| !std::is_sorted(offsets_.begin(), offsets_.end()) || !is_valid_capacity) {
+			throw snapshot::SnapshotError("wrong names in snapshot");
+		}
+		// A damaged table could have no empty slot for FindSlot to stop at.
+		// Rebuilding it from the hashes takes no longer than checking it
+		Rehash(slots_.size());
+	}
+
+	void NamePool::Rehash(size_t capacity) {
+		slots_.assign(capacity, EMPTY_SLOT);
+
+		const size_t mask = capacity - 1;
+		for (Id id = 0; id < Size(); ++id) {
+			size_t index = hashes_[id] & mask;
+			while (slots_[index] != EMPTY_SLOT) {
+				index = (index + 1) & mask;
+			}
+			slots_[index] = id;
+		}
+	}
+
+} // namespace catalogue
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "snapshot.h"
+
+namespace catalogue {
+
+	// Interned names. All names are stored back to back in one arena and get
+	// dense ids in the order they are added. The hash of every name is
+	// computed once and kept next to it, so probing the table and growing
+	// it compare hashes before touching the strings
+	class NamePool {
+	public:
+		using Id = uint32_t;
+
+		// Returns the id of name and whether it was added just now
+		std::pair<Id, bool> Intern(std::string_view name);
+
+		std::optional<Id> Find(std::string_view name) const;
+
+		// The view stays valid until the next name is added
+		std::string_view Get(Id id) const;
+
+		size_t Size() const;
+
+		// The hashes are part of the snapshot, so they do not depend on
+		// the standard library
+		void Save(snapshot::Writer& writer) const;
+		void Load(snapshot::Reader& reader);
+
+	private:
+		static constexpr Id EMPTY_SLOT = UINT32_MAX;
+
+		std::string arena_;
+		// Name i is arena_[offsets_[i], offsets_[i + 1])
+		std::vector<uint32_t> offsets_ = { 0 };
+		std::vector<uint64_t> hashes_;
+		std::vector<Id> slots_;
+
+		static uint64_t Hash(std::string_view name);
+		size_t FindSlot(std::string_view name, uint64_t hash) const;
+		void Rehash(size_t capacity);
+	};
+
+} // namespace catalogue
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Вызывает func(i) для каждого i из [0, count) в threads потоках.
+ * Потоки разбирают индексы по одному через общий счётчик, поэтому
+ * неравные по времени задачи распределяются сами. threads == 0 означает
+ * число ядер. Первое исключение из func пробрасывается после того,
+ * как все потоки завершатся; оставшиеся индексы при этом не обрабатываются.
+ */
+template <typename Func>
+void ParallelFor(size_t count, size_t threads, Func func) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, count);
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{ 0 };
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto work = [&] {
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                func(i);
+            }
+            catch (...) {
+                std::lock_guard lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next = count;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (size_t t = 1; t < threads; ++t) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * Точка встречи count потоков: Wait возвращается, когда его вызвали все
+ * count потоков. После этого барьер готов к следующей встрече.
+ */
+class Barrier {
+public:
+    explicit Barrier(size_t count)
+        : count_(count) {
+    }
+
+    void Wait() {
+        std::unique_lock lock(mutex_);
+        const size_t generation = generation_;
+        if (++waiting_ == count_) {
+            waiting_ = 0;
+            ++generation_;
+            all_came_.notify_all();
+            return;
+        }
+        all_came_.wait(lock, [&] { return generation != generation_; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable all_came_;
+    size_t count_;
+    size_t waiting_ = 0;
+    size_t generation_ = 0;
+};
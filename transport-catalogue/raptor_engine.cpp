@@ -0,0 +1,194 @@
+#include "raptor_engine.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace catalogue {
+
+	namespace {
+		constexpr double NOT_REACHED = std::numeric_limits<double>::infinity();
+		constexpr uint32_t NOT_QUEUED = std::numeric_limits<uint32_t>::max();
+	}
+
+	RaptorEngine::RaptorEngine(const TransportCatalogue& catalogue, double bus_velocity, double bus_wait_time)
+		: bus_velocity_(bus_velocity)
+		, bus_wait_time_(bus_wait_time) {
+		if (bus_wait_time < 0) {
+			throw std::domain_error("Edges' weights should be non-negative");
+		}
+
+		// The same directions the graph is built from: a circular bus goes
+		// through all its stops, a direct one goes through the first half
+		// of them there and back
+		for (BusId bus = 0; bus < catalogue.GetBusCount(); ++bus) {
+			const IdSpan<StopId> stops = catalogue.GetBusStops(bus);
+			if (catalogue.GetBusType(bus) == TypeRoute::CIRCLE) {
+				AddPattern(catalogue, bus, stops.begin(), stops.end());
+			}
+			else {
+				const size_t half = (stops.size() + 1) / 2;
+				const std::reverse_iterator<const StopId*> rend(stops.begin());
+				AddPattern(catalogue, bus, stops.begin(), stops.begin() + half);
+				AddPattern(catalogue, bus, rend - half, rend);
+			}
+		}
+		if (pattern_stops_.size() >= NOT_QUEUED || patterns_.size() >= NOT_QUEUED) {
+			throw std::length_error("too many bus stops to route");
+		}
+
+		const size_t stop_count = catalogue.GetStopCount();
+		stop_offsets_.assign(stop_count + 1, 0);
+		for (const StopId stop : pattern_stops_) {
+			++stop_offsets_[stop + 1];
+		}
+		for (size_t stop = 0; stop < stop_count; ++stop) {
+			stop_offsets_[stop + 1] += stop_offsets_[stop];
+		}
+		stop_patterns_.resize(pattern_stops_.size());
+		std::vector<uint32_t> next(stop_offsets_.begin(), stop_offsets_.end() - 1);
+		for (uint32_t pattern = 0; pattern < patterns_.size(); ++pattern) {
+			for (uint32_t position = 0; position < patterns_[pattern].size; ++position) {
+				const StopId stop = pattern_stops_[patterns_[pattern].first + position];
+				stop_patterns_[next[stop]++] = PatternStop{ pattern, position };
+			}
+		}
+
+		weights_.assign(stop_count, NOT_REACHED);
+		arrivals_.resize(stop_count);
+		marked_.assign(stop_count, false);
+		scan_from_.assign(patterns_.size(), NOT_QUEUED);
+	}
+
+	template <typename Iter>
+	void RaptorEngine::AddPattern(const TransportCatalogue& catalogue, BusId bus, Iter first, Iter last) {
+		if (first == last) {
+			return;
+		}
+		const uint32_t pattern_first = static_cast<uint32_t>(pattern_stops_.size());
+		uint64_t distance = 0;
+		for (Iter it = first; it != last; ++it) {
+			if (it != first) {
+				distance += catalogue.GetDistance(*std::prev(it), *it);
+			}
+			pattern_stops_.push_back(*it);
+			pattern_distances_.push_back(distance);
+		}
+		patterns_.push_back(Pattern{
+			bus, pattern_first, static_cast<uint32_t>(pattern_stops_.size() - pattern_first)
+		});
+	}
+
+	std::optional<RouteStat> RaptorEngine::BuildRoute(StopId from, StopId to) const {
+		if (from >= weights_.size() || to >= weights_.size()) {
+			throw std::out_of_range("unknown stop");
+		}
+
+		std::lock_guard lock(mutex_);
+		ResetSearch();
+
+		weights_[from] = 0;
+		reached_.push_back(from);
+		marked_[from] = true;
+		marked_stops_.push_back(from);
+
+		// Each round rides the buses through the stops improved in the
+		// previous one. Routes through the last stop are not taken further
+		while (!marked_stops_.empty()) {
+			for (const StopId stop : marked_stops_) {
+				marked_[stop] = false;
+				for (uint32_t i = stop_offsets_[stop]; i < stop_offsets_[stop + 1]; ++i) {
+					const PatternStop& pattern_stop = stop_patterns_[i];
+					uint32_t& scan_from = scan_from_[pattern_stop.pattern];
+					if (scan_from == NOT_QUEUED) {
+						queued_patterns_.push_back(pattern_stop.pattern);
+					}
+					scan_from = std::min(scan_from, pattern_stop.position);
+				}
+			}
+			marked_stops_.clear();
+
+			for (const uint32_t pattern : queued_patterns_) {
+				ScanPattern(pattern, scan_from_[pattern], to);
+				scan_from_[pattern] = NOT_QUEUED;
+			}
+			queued_patterns_.clear();
+		}
+
+		if (weights_[to] == NOT_REACHED) {
+			return std::nullopt;
+		}
+		return MakeRoute(from, to);
+	}
+
+	void RaptorEngine::ScanPattern(uint32_t pattern_id, uint32_t from_position, StopId to) const {
+		const Pattern& pattern = patterns_[pattern_id];
+		const StopId* stops = pattern_stops_.data() + pattern.first;
+
+		// The position the bus is boarded at and the weight of the route
+		// there, waiting included
+		bool boarded = false;
+		uint32_t board = 0;
+		double board_weight = 0;
+		for (uint32_t position = from_position; position < pattern.size; ++position) {
+			const StopId stop = stops[position];
+			double ride_weight = NOT_REACHED;
+			if (boarded) {
+				ride_weight = board_weight + GetRideWeight(pattern, board, position);
+				if (ride_weight < weights_[stop] && ride_weight < weights_[to]) {
+					if (weights_[stop] == NOT_REACHED) {
+						reached_.push_back(stop);
+					}
+					weights_[stop] = ride_weight;
+					arrivals_[stop] = Arrival{ pattern_id, board, position };
+					if (!marked_[stop] && stop != to) {
+						marked_[stop] = true;
+						marked_stops_.push_back(stop);
+					}
+				}
+			}
+
+			// Boarding here again is better than staying on the bus when the
+			// stop is reached sooner by another way
+			const double wait_weight = weights_[stop] + bus_wait_time_;
+			if (wait_weight < ride_weight && wait_weight < weights_[to]) {
+				boarded = true;
+				board = position;
+				board_weight = wait_weight;
+			}
+		}
+	}
+
+	double RaptorEngine::GetRideWeight(const Pattern& pattern, uint32_t board, uint32_t alight) const {
+		const uint64_t distance = pattern_distances_[pattern.first + alight]
+			- pattern_distances_[pattern.first + board];
+		return double(distance) / bus_velocity_;
+	}
+
+	RouteStat RaptorEngine::MakeRoute(StopId from, StopId to) const {
+		RouteStat route;
+		for (StopId stop = to; stop != from;) {
+			const Arrival& arrival = arrivals_[stop];
+			const Pattern& pattern = patterns_[arrival.pattern];
+			const StopId board_stop = pattern_stops_[pattern.first + arrival.board];
+			route.items.push_back(EdgeBusInfo{
+				pattern.bus, GetRideWeight(pattern, arrival.board, arrival.alight), arrival.alight - arrival.board
+			});
+			route.items.push_back(EdgeWaitInfo{ board_stop, bus_wait_time_ });
+			stop = board_stop;
+		}
+		std::reverse(route.items.begin(), route.items.end());
+		route.total_time = SumItemWeights(route.items);
+		return route;
+	}
+
+	void RaptorEngine::ResetSearch() const {
+		for (const StopId stop : reached_) {
+			weights_[stop] = NOT_REACHED;
+		}
+		reached_.clear();
+	}
+
+} // namespace catalogue
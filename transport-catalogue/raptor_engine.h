@@ -0,0 +1,78 @@
+#pragma once
+
+#include "domain.h"
+#include "transport_catalogue.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace catalogue {
+
+	// Searches on request without a graph, working on the stop sequences of
+	// the buses in rounds (RAPTOR). Each round scans the sequences that pass
+	// the stops improved in the previous round, riding every bus from the
+	// best stop to board it. The graph instead has an edge from every stop of
+	// a bus to every later one, which is quadratic in the length of the
+	// route; here memory is linear in the total length of the routes
+	class RaptorEngine {
+	public:
+		RaptorEngine(const TransportCatalogue& catalogue, double bus_velocity, double bus_wait_time);
+
+		std::optional<RouteStat> BuildRoute(StopId from, StopId to) const;
+
+	private:
+		// The stops a bus passes in one direction. Its stops and the road
+		// distances to them from the first one are at [first, first + size)
+		struct Pattern {
+			BusId bus;
+			uint32_t first;
+			uint32_t size;
+		};
+
+		struct PatternStop {
+			uint32_t pattern;
+			uint32_t position;
+		};
+
+		// How the best route to a stop ends: a ride on the pattern from
+		// position board to position alight
+		struct Arrival {
+			uint32_t pattern;
+			uint32_t board;
+			uint32_t alight;
+		};
+
+		double bus_velocity_;
+		double bus_wait_time_;
+
+		std::vector<Pattern> patterns_;
+		std::vector<StopId> pattern_stops_;
+		std::vector<uint64_t> pattern_distances_;
+		// The patterns passing stop s are at [stop_offsets_[s], stop_offsets_[s + 1])
+		std::vector<uint32_t> stop_offsets_;
+		std::vector<PatternStop> stop_patterns_;
+
+		// Search state, kept between requests. Only the stops reached by the
+		// previous search are reset
+		mutable std::mutex mutex_;
+		mutable std::vector<double> weights_;
+		mutable std::vector<Arrival> arrivals_;
+		mutable std::vector<StopId> reached_;
+		mutable std::vector<bool> marked_;
+		mutable std::vector<StopId> marked_stops_;
+		// The first position to scan for each queued pattern
+		mutable std::vector<uint32_t> scan_from_;
+		mutable std::vector<uint32_t> queued_patterns_;
+
+		template <typename Iter>
+		void AddPattern(const TransportCatalogue& catalogue, BusId bus, Iter first, Iter last);
+		void ScanPattern(uint32_t pattern, uint32_t from_position, StopId to) const;
+		double GetRideWeight(const Pattern& pattern, uint32_t board, uint32_t alight) const;
+		RouteStat MakeRoute(StopId from, StopId to) const;
+		void ResetSearch() const;
+	};
+
+} // namespace catalogue
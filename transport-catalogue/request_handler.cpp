@@ -1,7 +1,6 @@
 #include "request_handler.h"
 
 #include <string_view>
-#include <deque>
 
 namespace catalogue {
 
@@ -16,34 +15,36 @@ namespace catalogue {
 		return db_.GetBusInfo(bus_name);
 	}
 
-	const std::unordered_set<const Bus*> RequestHandler::GetBusesByStop(
-		const std::string_view& stop_name) const {
-
-		const std::unordered_set<const Bus*> a = db_.GetStopInfo(stop_name).buses;
-
-		return a;
+	IdSpan<BusId> RequestHandler::GetBusesByStop(const std::string_view& stop_name) const {
+		if (auto stop = db_.FindStop(stop_name)) {
+			return db_.GetBusesByStop(*stop);
+		}
+		return {};
 	}
 
-	const std::deque<const Stop*>& RequestHandler::GetStopsByBus(const std::string_view bus_name) const {
-		return db_.FindBus(bus_name)->stops;
+	IdSpan<StopId> RequestHandler::GetStopsByBus(const std::string_view bus_name) const {
+		if (auto bus = db_.FindBus(bus_name)) {
+			return db_.GetBusStops(*bus);
+		}
+		return {};
 	}
 
-	const std::unordered_set<const Bus*> RequestHandler::GetAllBuses() const {
+	IdSpan<BusId> RequestHandler::GetAllBuses() const {
 		return db_.GetAllBuses();
 	}
 
-	const std::unordered_set<const Stop*> RequestHandler::GetAllStops() const {
+	IdSpan<StopId> RequestHandler::GetAllStops() const {
 		return db_.GetAllStops();
 	}
 
 	svg::Document RequestHandler::RenderMap(const renderer::RenderSettings& render_settings,
-		const std::set< const Bus*, CompareBuses >& buses) const {
+		IdSpan<BusId> buses) const {
 		return renderer_.RenderMap(render_settings, buses);
 	}
 
-	std::optional<graph::Router<double>::RouteInfo> RequestHandler::BuildRoute(
-		std::string_view stop_from, std::string_view stop_to) const {
-		return router_.BuildRoute(stop_from, stop_to);
+	std::optional<RouteStat> RequestHandler::BuildRoute(std::string_view stop_from,
+		std::string_view stop_to, std::optional<double> departure_time) const {
+		return router_.BuildRoute(stop_from, stop_to, departure_time);
 	}
 
 } // namespace catalogue
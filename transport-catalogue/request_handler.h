@@ -2,8 +2,6 @@
 
 #include <optional>
 #include <string_view>
-#include <unordered_set>
-#include <deque>
 
 #include "domain.h"
 #include "transport_catalogue.h"
@@ -20,19 +18,20 @@ namespace catalogue {
 
         std::optional<BusInfo> GetBusStat(const std::string_view& bus_name) const;
 
-        const std::unordered_set<const Bus*> GetBusesByStop(const std::string_view& stop_name) const;
+        // Empty for an unknown stop or bus
+        IdSpan<BusId> GetBusesByStop(const std::string_view& stop_name) const;
 
-        const std::deque<const Stop*>& GetStopsByBus(const std::string_view bus_name) const;
+        IdSpan<StopId> GetStopsByBus(const std::string_view bus_name) const;
 
-        const std::unordered_set<const Bus*> GetAllBuses() const;
+        IdSpan<BusId> GetAllBuses() const;
 
-        const std::unordered_set<const Stop*> GetAllStops() const;
+        IdSpan<StopId> GetAllStops() const;
 
         svg::Document RenderMap(const renderer::RenderSettings& render_settings,
-            const std::set< const Bus*, CompareBuses >& buses) const;
+            IdSpan<BusId> buses) const;
 
-        std::optional<graph::Router<double>::RouteInfo> BuildRoute(
-            std::string_view stop_from, std::string_view stop_to) const;
+        std::optional<RouteStat> BuildRoute(std::string_view stop_from, std::string_view stop_to,
+            std::optional<double> departure_time = std::nullopt) const;
 
     private:
         const TransportCatalogue& db_;
@@ -40,4 +39,4 @@ namespace catalogue {
         const TransportRouter& router_;
     };
 
-} // namespace catalogueS
+} // namespace catalogue
@@ -0,0 +1,135 @@
+#include "road_distances.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+namespace catalogue {
+
+	bool RoadDistances::Set(StopId from, StopId to, size_t distance) {
+		if (distance >= NO_DISTANCE) {
+			throw std::invalid_argument("road distance is too long");
+		}
+
+		uint32_t& value = from <= to
+			? InsertSlot(MakeKey(from, to)).forward
+			: InsertSlot(MakeKey(from, to)).backward;
+		if (value != NO_DISTANCE) {
+			return false;
+		}
+		value = static_cast<uint32_t>(distance);
+		return true;
+	}
+
+	std::optional<size_t> RoadDistances::Find(StopId from, StopId to) const {
+		const Slot* slot = FindSlot(MakeKey(from, to));
+		if (!slot) {
+			return std::nullopt;
+		}
+
+		uint32_t direct = slot->forward;
+		uint32_t reverse = slot->backward;
+		if (from > to) {
+			std::swap(direct, reverse);
+		}
+		if (direct != NO_DISTANCE) {
+			return direct;
+		}
+		if (reverse != NO_DISTANCE) {
+			return reverse;
+		}
+		return std::nullopt;
+	}
+
+	size_t RoadDistances::Size() const {
+		return size_;
+	}
+
+	void RoadDistances::Save(snapshot::Writer& writer) const {
+		writer.Write(slots_);
+	}
+
+	void RoadDistances::Load(snapshot::Reader& reader) {
+		reader.Read(slots_);
+
+		if ((slots_.size() & (slots_.size() - 1)) != 0) {
+			throw snapshot::SnapshotError("wrong road distances in snapshot");
+		}
+		size_ = static_cast<size_t>(std::count_if(slots_.begin(), slots_.end(),
+			[](const Slot& slot) { return slot.key != EMPTY_KEY; }));
+		if (2 * size_ > slots_.size()) {
+			throw snapshot::SnapshotError("wrong road distances in snapshot");
+		}
+	}
+
+	uint64_t RoadDistances::MakeKey(StopId from, StopId to) {
+		const auto [low, high] = std::minmax(from, to);
+		return (static_cast<uint64_t>(low) << 32) | high;
+	}
+
+	// Finalizer of MurmurHash3: every bit of both ids affects the low bits
+	// that select the slot
+	size_t RoadDistances::Hash(uint64_t key) {
+		key ^= key >> 33;
+		key *= 0xff51afd7ed558ccdULL;
+		key ^= key >> 33;
+		key *= 0xc4ceb9fe1a85ec53ULL;
+		key ^= key >> 33;
+		return static_cast<size_t>(key);
+	}
+
+	const RoadDistances::Slot* RoadDistances::FindSlot(uint64_t key) const {
+		if (slots_.empty()) {
+			return nullptr;
+		}
+
+		const size_t mask = slots_.size() - 1;
+		for (size_t index = Hash(key) & mask; ; index = (index + 1) & mask) {
+			const Slot& slot = slots_[index];
+			if (slot.key == key) {
+				return &slot;
+			}
+			if (slot.key == EMPTY_KEY) {
+				return nullptr;
+			}
+		}
+	}
+
+	RoadDistances::Slot& RoadDistances::InsertSlot(uint64_t key) {
+		// the table is kept at most half full
+		if (2 * (size_ + 1) > slots_.size()) {
+			Rehash(std::max<size_t>(16, 2 * slots_.size()));
+		}
+
+		const size_t mask = slots_.size() - 1;
+		for (size_t index = Hash(key) & mask; ; index = (index + 1) & mask) {
+			Slot& slot = slots_[index];
+			if (slot.key == key) {
+				return slot;
+			}
+			if (slot.key == EMPTY_KEY) {
+				slot.key = key;
+				++size_;
+				return slot;
+			}
+		}
+	}
+
+	void RoadDistances::Rehash(size_t capacity) {
+		std::vector<Slot> old_slots(capacity);
+		old_slots.swap(slots_);
+
+		const size_t mask = slots_.size() - 1;
+		for (const Slot& old_slot : old_slots) {
+			if (old_slot.key == EMPTY_KEY) {
+				continue;
+			}
+			size_t index = Hash(old_slot.key) & mask;
+			while (slots_[index].key != EMPTY_KEY) {
+				index = (index + 1) & mask;
+			}
+			slots_[index] = old_slot;
+		}
+	}
+
+} // namespace catalogue
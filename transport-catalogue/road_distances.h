@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "domain.h"
+#include "snapshot.h"
+
+namespace catalogue {
+
+	// Road distances between stops in an open-addressing hash table.
+	// Both directions of a pair of stops share one slot, so a distance
+	// and its reverse fallback are found with a single probe sequence
+	class RoadDistances {
+	public:
+		// Keeps the distance that was set first. Returns false if the
+		// distance from -> to was already known
+		bool Set(StopId from, StopId to, size_t distance);
+
+		// The distance from -> to, or to -> from if only that one is known
+		std::optional<size_t> Find(StopId from, StopId to) const;
+
+		size_t Size() const;
+
+		void Save(snapshot::Writer& writer) const;
+		void Load(snapshot::Reader& reader);
+
+	private:
+		static constexpr uint64_t EMPTY_KEY = UINT64_MAX;
+		static constexpr uint32_t NO_DISTANCE = UINT32_MAX;
+
+		// forward goes from the smaller id to the greater one
+		struct Slot {
+			uint64_t key = EMPTY_KEY;
+			uint32_t forward = NO_DISTANCE;
+			uint32_t backward = NO_DISTANCE;
+		};
+
+		std::vector<Slot> slots_;
+		size_t size_ = 0;
+
+		static uint64_t MakeKey(StopId from, StopId to);
+		static size_t Hash(uint64_t key);
+		const Slot* FindSlot(uint64_t key) const;
+		Slot& InsertSlot(uint64_t key);
+		void Rehash(size_t capacity);
+	};
+
+} // namespace catalogue
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "frozen_graph.h"
+#include "graph.h"
+#include "router.h"
+
+#include <cstddef>
+#include <optional>
+
+namespace catalogue {
+
+	// Finds the fastest routes in the graph built by TransportRouter.
+	// Engines differ in what they prepare in advance and what they do per request
+	class RouteEngine {
+	public:
+		using Graph = FrozenGraph;
+		using RouteInfo = graph::Router<double>::RouteInfo;
+
+		virtual ~RouteEngine() = default;
+
+		// Edges of the route in the order they are passed
+		virtual std::optional<RouteInfo> BuildRoute(graph::VertexId from, graph::VertexId to) const = 0;
+
+		// Vertices settled by the last BuildRoute, to compare the engines;
+		// 0 when the route was looked up rather than searched for
+		virtual size_t GetSettledCount() const {
+			return 0;
+		}
+	};
+
+} // namespace catalogue
@@ -0,0 +1,142 @@
+#include "routes_table.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace catalogue {
+
+	namespace {
+		constexpr double NO_ROUTE = std::numeric_limits<double>::infinity();
+	}
+
+	RoutesTable::RoutesTable(const Graph& graph, size_t threads)
+		: graph_(graph)
+		, vertex_count_(graph.GetVertexCount()) {
+		if (graph.GetEdgeCount() >= NO_EDGE) {
+			throw std::length_error("too many edges for the routes table");
+		}
+
+		std::vector<double> weights(vertex_count_ * vertex_count_, NO_ROUTE);
+		std::vector<uint32_t> prev_edges(vertex_count_ * vertex_count_, NO_EDGE);
+		for (graph::VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+			const size_t row = vertex * vertex_count_;
+			weights[row + vertex] = 0;
+			for (uint32_t position = graph.GetFirstEdge(vertex); position < graph.GetFirstEdge(vertex + 1); ++position) {
+				const double weight = graph.GetWeight(position);
+				const graph::VertexId to = graph.GetTarget(position);
+				if (weight < 0) {
+					throw std::domain_error("Edges' weights should be non-negative");
+				}
+				if (weight < weights[row + to]) {
+					weights[row + to] = weight;
+					prev_edges[row + to] = static_cast<uint32_t>(graph.GetEdgeId(position));
+				}
+			}
+		}
+
+		// Each through vertex needs the table left by the previous one, so
+		// every thread relaxes its own rows and waits for the others before
+		// the next through vertex. The order of the relaxations of every
+		// entry stays the same as on one thread. ParallelFor gives each
+		// thread one part: a thread can't finish its part and take another
+		// one before every part has reached the barrier
+		if (threads == 0) {
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		}
+		threads = std::max<size_t>(1, std::min(threads, vertex_count_));
+		Barrier barrier(threads);
+		ParallelFor(threads, threads, [&](size_t part) {
+			const size_t rows_begin = vertex_count_ * part / threads;
+			const size_t rows_end = vertex_count_ * (part + 1) / threads;
+			for (graph::VertexId through = 0; through < vertex_count_; ++through) {
+				RelaxThroughVertex(weights, prev_edges, vertex_count_, through, rows_begin, rows_end);
+				barrier.Wait();
+			}
+		});
+		weights_ = snapshot::Array<double>(std::move(weights));
+		prev_edges_ = snapshot::Array<uint32_t>(std::move(prev_edges));
+	}
+
+	// Rows are independent for a fixed through vertex: the row of through
+	// itself can't change, since its weight to itself is 0
+	void RoutesTable::RelaxThroughVertex(std::vector<double>& all_weights, std::vector<uint32_t>& all_edges,
+		size_t vertex_count, graph::VertexId through, size_t rows_begin, size_t rows_end) {
+		const double* through_weights = &all_weights[through * vertex_count];
+		const uint32_t* through_edges = &all_edges[through * vertex_count];
+
+		for (graph::VertexId from = rows_begin; from < rows_end; ++from) {
+			const size_t row = from * vertex_count;
+			const double weight_to_through = all_weights[row + through];
+			if (weight_to_through == NO_ROUTE) {
+				continue;
+			}
+			const uint32_t edge_to_through = all_edges[row + through];
+			double* weights = &all_weights[row];
+			uint32_t* edges = &all_edges[row];
+
+			for (graph::VertexId to = 0; to < vertex_count; ++to) {
+				const double candidate = weight_to_through + through_weights[to];
+				if (candidate < weights[to]) {
+					weights[to] = candidate;
+					edges[to] = through_edges[to] != NO_EDGE ? through_edges[to] : edge_to_through;
+				}
+			}
+		}
+	}
+
+	RoutesTable::RoutesTable(const Graph& graph, snapshot::Reader& reader)
+		: graph_(graph)
+		, vertex_count_(graph.GetVertexCount()) {
+		std::vector<uint64_t> vertex_count;
+		reader.Read(vertex_count);
+		reader.Read(weights_);
+		reader.Read(prev_edges_);
+
+		if (vertex_count.size() != 1 || vertex_count[0] != vertex_count_
+			|| weights_.size() != vertex_count_ * vertex_count_ || prev_edges_.size() != weights_.size()) {
+			throw snapshot::SnapshotError("wrong routes table in snapshot");
+		}
+		// BuildRoute goes back from to along the edges without checks, so
+		// every edge has to exist and end where the table says
+		for (size_t entry = 0; entry < prev_edges_.size(); ++entry) {
+			const uint32_t edge_id = prev_edges_[entry];
+			if (edge_id != NO_EDGE
+				&& (edge_id >= graph.GetEdgeCount() || graph.GetEdge(edge_id).to != entry % vertex_count_)) {
+				throw snapshot::SnapshotError("wrong routes table in snapshot");
+			}
+		}
+	}
+
+	std::optional<RoutesTable::RouteInfo> RoutesTable::BuildRoute(
+		graph::VertexId from, graph::VertexId to) const {
+		if (from >= vertex_count_ || to >= vertex_count_) {
+			throw std::out_of_range("unknown vertex");
+		}
+
+		const size_t row = from * vertex_count_;
+		if (weights_[row + to] == NO_ROUTE) {
+			return std::nullopt;
+		}
+
+		std::vector<graph::EdgeId> edges;
+		for (uint32_t edge_id = prev_edges_[row + to]; edge_id != NO_EDGE;
+			edge_id = prev_edges_[row + graph_.GetEdgeFrom(edge_id)]) {
+			edges.push_back(edge_id);
+		}
+		std::reverse(edges.begin(), edges.end());
+
+		return RouteInfo{ weights_[row + to], std::move(edges) };
+	}
+
+	void RoutesTable::Save(snapshot::Writer& writer) const {
+		const uint64_t vertex_count = vertex_count_;
+		writer.Write(&vertex_count, 1);
+		writer.Write(weights_);
+		writer.Write(prev_edges_);
+	}
+
+} // namespace catalogue
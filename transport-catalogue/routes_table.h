@@ -0,0 +1,47 @@
+#pragma once
+
+#include "graph.h"
+#include "route_engine.h"
+#include "router.h"
+#include "snapshot.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace catalogue {
+
+	// Shortest routes between all pairs of vertices. They are found the same
+	// way graph::Router finds them, so the routes are the same, but both
+	// V x V tables are flat arrays that can be saved and loaded as they are.
+	// The graph has to outlive the table
+	class RoutesTable final : public RouteEngine {
+	public:
+		// Builds on threads threads, 0 means one per core. The table is the
+		// same for any number of threads
+		explicit RoutesTable(const Graph& graph, size_t threads = 0);
+		// Loads the table saved for graph. Throws snapshot::SnapshotError if
+		// it does not fit the graph
+		RoutesTable(const Graph& graph, snapshot::Reader& reader);
+
+		std::optional<RouteInfo> BuildRoute(graph::VertexId from, graph::VertexId to) const override;
+
+		void Save(snapshot::Writer& writer) const;
+
+	private:
+		static constexpr uint32_t NO_EDGE = UINT32_MAX;
+
+		const Graph& graph_;
+		size_t vertex_count_ = 0;
+		// Row from, column to: weight of the shortest route (infinity if there
+		// is none) and the last edge of it (NO_EDGE for an empty route). A
+		// loaded table is read straight from the mapped file
+		snapshot::Array<double> weights_;
+		snapshot::Array<uint32_t> prev_edges_;
+
+		static void RelaxThroughVertex(std::vector<double>& all_weights, std::vector<uint32_t>& all_edges,
+			size_t vertex_count, graph::VertexId through, size_t rows_begin, size_t rows_end);
+	};
+
+} // namespace catalogue
@@ -0,0 +1,140 @@
+#include "simd_scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCAN_X86_DISPATCH
+#include <immintrin.h>
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define SCAN_SSE2_ONLY
+#include <emmintrin.h>
+#include <intrin.h>
+#endif
+
+namespace scan {
+
+    namespace {
+
+        template <char... Chars>
+        bool IsOneOf(char c) {
+            return ((c == Chars) || ...);
+        }
+
+        template <char... Chars>
+        const char* FindScalar(const char* pos, const char* end) {
+            while (pos != end && !IsOneOf<Chars...>(*pos)) {
+                ++pos;
+            }
+            return pos;
+        }
+
+#if defined(SCAN_X86_DISPATCH) || defined(SCAN_SSE2_ONLY)
+
+#ifdef SCAN_X86_DISPATCH
+#define SCAN_TARGET(arch) __attribute__((target(arch)))
+#else
+#define SCAN_TARGET(arch)
+#endif
+
+        int TrailingZeros(unsigned mask) {
+#ifdef SCAN_X86_DISPATCH
+            return __builtin_ctz(mask);
+#else
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return static_cast<int>(index);
+#endif
+        }
+
+        // Маска совпадений в 16 байтах, начиная с pos
+        template <char... Chars>
+        SCAN_TARGET("sse2") inline int Match16(const char* pos) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+            __m128i hits = _mm_setzero_si128();
+            ((hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, _mm_set1_epi8(Chars)))), ...);
+            return _mm_movemask_epi8(hits);
+        }
+
+        template <char... Chars>
+        SCAN_TARGET("sse2") const char* FindSse2(const char* pos, const char* end) {
+            for (; end - pos >= 16; pos += 16) {
+                if (const int mask = Match16<Chars...>(pos); mask != 0) {
+                    return pos + TrailingZeros(static_cast<unsigned>(mask));
+                }
+            }
+            return FindScalar<Chars...>(pos, end);
+        }
+
+#endif
+
+#ifdef SCAN_X86_DISPATCH
+
+        template <char... Chars>
+        SCAN_TARGET("avx2") const char* FindAvx2(const char* pos, const char* end) {
+            for (; end - pos >= 32; pos += 32) {
+                const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+                __m256i hits = _mm256_setzero_si256();
+                ((hits = _mm256_or_si256(hits, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(Chars)))), ...);
+                if (const int mask = _mm256_movemask_epi8(hits); mask != 0) {
+                    return pos + TrailingZeros(static_cast<unsigned>(mask));
+                }
+            }
+            // Хвост обрабатывается здесь же: вызов функции, собранной без AVX,
+            // после 256-битных команд обходится дорого
+            if (end - pos >= 16) {
+                if (const int mask = Match16<Chars...>(pos); mask != 0) {
+                    return pos + TrailingZeros(static_cast<unsigned>(mask));
+                }
+                pos += 16;
+            }
+            return FindScalar<Chars...>(pos, end);
+        }
+
+#endif
+
+        using FindFunction = const char* (*)(const char*, const char*);
+
+        template <char... Chars>
+        FindFunction SelectFind() {
+#if defined(SCAN_X86_DISPATCH)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2")) {
+                return FindAvx2<Chars...>;
+            }
+            return FindSse2<Chars...>;
+#elif defined(SCAN_SSE2_ONLY)
+            return FindSse2<Chars...>;
+#else
+            return FindScalar<Chars...>;
+#endif
+        }
+
+        // Короткий текст быстрее просмотреть без вызова через указатель
+        constexpr long SHORT_TEXT = 16;
+
+        template <char... Chars>
+        const char* Find(const char* begin, const char* end) {
+            if (end - begin < SHORT_TEXT) {
+                return FindScalar<Chars...>(begin, end);
+            }
+            static const FindFunction find = SelectFind<Chars...>();
+            return find(begin, end);
+        }
+
+    }  // namespace
+
+    const char* FindJsonSpecial(const char* begin, const char* end) {
+        return Find<'"', '\\', '\r', '\n'>(begin, end);
+    }
+
+    const char* FindQuoteOrBackslash(const char* begin, const char* end) {
+        return Find<'"', '\\'>(begin, end);
+    }
+
+    const char* FindStructural(const char* begin, const char* end) {
+        return Find<'"', '[', ']', '{', '}'>(begin, end);
+    }
+
+    const char* FindXmlSpecial(const char* begin, const char* end) {
+        return Find<'&', '<', '>', '\'', '"'>(begin, end);
+    }
+
+}  // namespace scan
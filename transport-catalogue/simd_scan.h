@@ -0,0 +1,23 @@
+#pragma once
+
+namespace scan {
+
+    // Ищут в [begin, end) первый символ, который требует обработки, и
+    // возвращают указатель на него или end. Текст просматривается блоками
+    // по 32 байта (AVX2) или 16 байт (SSE2); набор инструкций выбирается
+    // при первом вызове по возможностям процессора. Без SIMD используется
+    // обычный посимвольный поиск
+
+    // '"', '\\', '\r', '\n' - конец строки JSON или экранирование
+    const char* FindJsonSpecial(const char* begin, const char* end);
+
+    // '"', '\\' - конец строки JSON при пропуске значения без разбора
+    const char* FindQuoteOrBackslash(const char* begin, const char* end);
+
+    // '"', '[', ']', '{', '}' - границы вложенных значений JSON
+    const char* FindStructural(const char* begin, const char* end);
+
+    // '&', '<', '>', '\'', '"' - символы, заменяемые в тексте SVG
+    const char* FindXmlSpecial(const char* begin, const char* end);
+
+}  // namespace scan
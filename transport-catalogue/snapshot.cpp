@@ -0,0 +1,197 @@
+#include "snapshot.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SNAPSHOT_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace catalogue {
+
+	namespace snapshot {
+
+		namespace {
+
+			constexpr char MAGIC[8] = { 'T', 'C', 'S', 'N', 'A', 'P', '\0', '\0' };
+			// Raised whenever the layout of any section changes
+			constexpr uint32_t VERSION = 3;
+			// Read back differently on a machine with the other byte order
+			constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+			struct Header {
+				char magic[8];
+				uint32_t version;
+				uint32_t byte_order_mark;
+				uint64_t payload_size;
+				uint64_t checksum;
+			};
+
+			// Processes the data 8 bytes at a time, so checking a large
+			// snapshot costs little compared with reading it
+			uint64_t Checksum(const char* data, size_t size) {
+				uint64_t hash = 0x9e3779b97f4a7c15ULL ^ size;
+				size_t pos = 0;
+				for (; pos + 8 <= size; pos += 8) {
+					uint64_t word;
+					std::memcpy(&word, data + pos, 8);
+					hash ^= word * 0x87c37b91114253d5ULL;
+					hash = ((hash << 31) | (hash >> 33)) * 0x4cf5ad432745937fULL;
+				}
+				for (; pos < size; ++pos) {
+					hash = (hash ^ static_cast<unsigned char>(data[pos])) * 0x100000001b3ULL;
+				}
+				hash ^= hash >> 33;
+				return hash;
+			}
+
+		} // namespace
+
+		// The whole file: mapped, or read into a buffer where mapping is
+		// not available
+		class Reader::Mapping {
+		public:
+			explicit Mapping(const std::string& path) {
+#ifdef SNAPSHOT_MMAP
+				const int fd = ::open(path.c_str(), O_RDONLY);
+				if (fd >= 0) {
+					struct stat info;
+					if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+						void* address = ::mmap(nullptr, static_cast<size_t>(info.st_size),
+							PROT_READ, MAP_PRIVATE, fd, 0);
+						if (address != MAP_FAILED) {
+							data_ = static_cast<const char*>(address);
+							size_ = static_cast<size_t>(info.st_size);
+							is_mapped_ = true;
+						}
+					}
+					::close(fd);
+				}
+#endif
+				if (!is_mapped_) {
+					std::ifstream input(path, std::ios::binary);
+					if (!input) {
+						throw SnapshotError("can't open snapshot " + path);
+					}
+					buffer_.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+					data_ = buffer_.data();
+					size_ = buffer_.size();
+				}
+			}
+
+			Mapping(const Mapping&) = delete;
+			Mapping& operator=(const Mapping&) = delete;
+
+			~Mapping() {
+#ifdef SNAPSHOT_MMAP
+				if (is_mapped_) {
+					::munmap(const_cast<char*>(data_), size_);
+				}
+#endif
+			}
+
+			const char* GetData() const {
+				return data_;
+			}
+
+			size_t GetSize() const {
+				return size_;
+			}
+
+		private:
+			const char* data_ = nullptr;
+			size_t size_ = 0;
+			std::string buffer_;
+			bool is_mapped_ = false;
+		};
+
+		void Writer::Save(const std::string& path) const {
+			Header header{};
+			std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+			header.version = VERSION;
+			header.byte_order_mark = BYTE_ORDER_MARK;
+			header.payload_size = payload_.size();
+			header.checksum = Checksum(payload_.data(), payload_.size());
+
+			// Truncating a mapped file would break the arrays that point into
+			// it, while a renamed file stays mapped until they are gone
+			const std::string temp_path = path + ".tmp";
+			{
+				std::ofstream output(temp_path, std::ios::binary | std::ios::trunc);
+				output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+				output.write(payload_.data(), static_cast<std::streamsize>(payload_.size()));
+				output.flush();
+				if (!output) {
+					std::remove(temp_path.c_str());
+					throw SnapshotError("can't write snapshot " + path);
+				}
+			}
+			// Where rename doesn't replace an existing file, it is removed first
+			if (std::rename(temp_path.c_str(), path.c_str()) != 0
+				&& (std::remove(path.c_str()) != 0 || std::rename(temp_path.c_str(), path.c_str()) != 0)) {
+				std::remove(temp_path.c_str());
+				throw SnapshotError("can't write snapshot " + path);
+			}
+		}
+
+		uint64_t Writer::GetChecksum() const {
+			return Checksum(payload_.data(), payload_.size());
+		}
+
+		Reader::Reader(const std::string& path)
+			: mapping_(std::make_shared<const Mapping>(path))
+			, data_(mapping_->GetData())
+			, size_(mapping_->GetSize()) {
+			Header header;
+			if (size_ < sizeof(header)) {
+				throw SnapshotError("snapshot " + path + " is truncated");
+			}
+			std::memcpy(&header, data_, sizeof(header));
+			if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+				throw SnapshotError(path + " is not a snapshot");
+			}
+			if (header.version != VERSION || header.byte_order_mark != BYTE_ORDER_MARK) {
+				throw SnapshotError("snapshot " + path + " was made by an incompatible build");
+			}
+			if (header.payload_size != size_ - sizeof(header)) {
+				throw SnapshotError("snapshot " + path + " is truncated");
+			}
+			if (header.checksum != Checksum(data_ + sizeof(header), size_ - sizeof(header))) {
+				throw SnapshotError("snapshot " + path + " is damaged");
+			}
+			pos_ = sizeof(header);
+		}
+
+		std::string_view Reader::ReadText() {
+			return ReadSection(1);
+		}
+
+		bool Reader::AtEnd() const {
+			return pos_ == size_;
+		}
+
+		std::string_view Reader::ReadSection(size_t element_size) {
+			uint64_t size;
+			if (size_ - pos_ < sizeof(size)) {
+				throw SnapshotError("snapshot has fewer sections than expected");
+			}
+			std::memcpy(&size, data_ + pos_, sizeof(size));
+			pos_ += sizeof(size);
+
+			const uint64_t padded_size = (size + 7) / 8 * 8;
+			if (size % element_size != 0 || padded_size < size || size_ - pos_ < padded_size) {
+				throw SnapshotError("snapshot section has a wrong size");
+			}
+			const std::string_view section(data_ + pos_, static_cast<size_t>(size));
+			pos_ += static_cast<size_t>(padded_size);
+			return section;
+		}
+
+	} // namespace snapshot
+
+} // namespace catalogue
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace catalogue {
+
+	namespace snapshot {
+
+		// The snapshot can't be read, is damaged or was made by a build
+		// with a different layout
+		class SnapshotError : public std::runtime_error {
+		public:
+			using runtime_error::runtime_error;
+		};
+
+		// Read-only array that points into a mapped snapshot instead of
+		// copying the section out of it. The file stays mapped while any
+		// array made from it is alive. An array can also own a vector, so
+		// data that is either built or loaded needs one member for both
+		template <typename T>
+		class Array {
+		public:
+			Array() = default;
+
+			explicit Array(std::vector<T> values) {
+				auto owner = std::make_shared<const std::vector<T>>(std::move(values));
+				data_ = owner->data();
+				size_ = owner->size();
+				owner_ = std::move(owner);
+			}
+
+			const T* data() const {
+				return data_;
+			}
+
+			size_t size() const {
+				return size_;
+			}
+
+			bool empty() const {
+				return size_ == 0;
+			}
+
+			const T& operator[](size_t index) const {
+				return data_[index];
+			}
+
+			const T& front() const {
+				return data_[0];
+			}
+
+			const T& back() const {
+				return data_[size_ - 1];
+			}
+
+			const T* begin() const {
+				return data_;
+			}
+
+			const T* end() const {
+				return data_ + size_;
+			}
+
+		private:
+			friend class Reader;
+
+			std::shared_ptr<const void> owner_;
+			const T* data_ = nullptr;
+			size_t size_ = 0;
+		};
+
+		// Collects the sections of a snapshot. A section is an array of
+		// trivially copyable values: its size in bytes followed by the bytes,
+		// padded to 8 bytes. The data holds offsets and ids, never pointers
+		class Writer {
+		public:
+			template <typename T>
+			void Write(const T* data, size_t count);
+
+			template <typename T>
+			void Write(const std::vector<T>& values) {
+				Write(values.data(), values.size());
+			}
+
+			template <typename T>
+			void Write(const Array<T>& values) {
+				Write(values.data(), values.size());
+			}
+
+			void Write(std::string_view text) {
+				Write(text.data(), text.size());
+			}
+
+			// Writes the header with the checksum of the sections and the
+			// sections themselves. The file is written next to path and then
+			// renamed, so arrays of an older file at path stay valid
+			void Save(const std::string& path) const;
+
+			// Checksum of the sections written so far
+			uint64_t GetChecksum() const;
+
+		private:
+			std::string payload_;
+		};
+
+		// Maps a snapshot file into memory (or reads it where mapping is not
+		// available), checks the header and the checksum and then reads the
+		// sections in the order they were written
+		class Reader {
+		public:
+			explicit Reader(const std::string& path);
+			Reader(const Reader&) = delete;
+			Reader& operator=(const Reader&) = delete;
+
+			// Copies the section, for data that is changed after loading
+			template <typename T>
+			void Read(std::vector<T>& values);
+
+			// Points into the file without copying
+			template <typename T>
+			void Read(Array<T>& values);
+
+			std::string_view ReadText();
+
+			// Every section has been read
+			bool AtEnd() const;
+
+		private:
+			class Mapping;
+
+			std::shared_ptr<const Mapping> mapping_;
+			const char* data_ = nullptr;
+			size_t size_ = 0;
+			size_t pos_ = 0;
+
+			std::string_view ReadSection(size_t element_size);
+		};
+
+		template <typename T>
+		void Writer::Write(const T* data, size_t count) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			const uint64_t size = count * sizeof(T);
+			payload_.append(reinterpret_cast<const char*>(&size), sizeof(size));
+			payload_.append(reinterpret_cast<const char*>(data), size);
+			payload_.resize((payload_.size() + 7) / 8 * 8, '\0');
+		}
+
+		template <typename T>
+		void Reader::Read(std::vector<T>& values) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			const std::string_view section = ReadSection(sizeof(T));
+			values.resize(section.size() / sizeof(T));
+			if (!section.empty()) {
+				std::memcpy(values.data(), section.data(), section.size());
+			}
+		}
+
+		template <typename T>
+		void Reader::Read(Array<T>& values) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			const std::string_view section = ReadSection(sizeof(T));
+			// Sections start at multiples of 8 bytes from the beginning of
+			// the file, so only an unusual T needs a copy
+			if (reinterpret_cast<uintptr_t>(section.data()) % alignof(T) != 0) {
+				std::vector<T> copy(section.size() / sizeof(T));
+				if (!section.empty()) {
+					std::memcpy(copy.data(), section.data(), section.size());
+				}
+				values = Array<T>(std::move(copy));
+				return;
+			}
+			values.owner_ = mapping_;
+			values.data_ = reinterpret_cast<const T*>(section.data());
+			values.size_ = section.size() / sizeof(T);
+		}
+
+	} // namespace snapshot
+
+} // namespace catalogue
@@ -1,4 +1,5 @@
 #include "svg.h"
+#include "simd_scan.h"
 
 namespace svg {
     using namespace std::literals;
@@ -163,37 +164,35 @@ namespace svg {
         out << "/text>"sv;
     }
 
+    // Участки без спецсимволов копируются целиком
     std::string Text::ConvertTextToSVG() const {
-        std::string text = data_;
-        
-        ConvertSymbolToSVG(text, '&');
-        ConvertSymbolToSVG(text, '<');
-        ConvertSymbolToSVG(text, '>');
-        ConvertSymbolToSVG(text, '\'');
-        ConvertSymbolToSVG(text, '"');
+        std::string text;
+        text.reserve(data_.size());
+
+        const char* pos = data_.data();
+        const char* end = pos + data_.size();
+        while (pos != end) {
+            const char* run = pos;
+            pos = scan::FindXmlSpecial(pos, end);
+            text.append(run, pos);
+            if (pos == end) {
+                break;
+            }
+            text += ConvertSymbolToSVG(*pos++);
+        }
 
         return text;
     }
 
-    void Text::ConvertSymbolToSVG(std::string& text, char symbol) const {
-        std::string svg_format;
+    std::string_view Text::ConvertSymbolToSVG(char symbol) {
         switch (symbol) {
-        case  '&': svg_format = "&amp;";  break;
-        case  '<': svg_format = "&lt;";   break;
-        case  '>': svg_format = "&gt;";   break;
-        case '\'': svg_format = "&apos;"; break;
-        case  '"': svg_format = "&quot;"; break;
-        }
-
-        size_t count = std::count(text.begin(), text.end(), symbol);
-
-        size_t pos = text.find(symbol);
-        size_t i = 1;
-        while (i <= count) {
-            text = text.replace(pos, 1, svg_format);
-            pos = text.find(symbol);
-            ++i;
+        case  '&': return "&amp;"sv;
+        case  '<': return "&lt;"sv;
+        case  '>': return "&gt;"sv;
+        case '\'': return "&apos;"sv;
+        case  '"': return "&quot;"sv;
         }
+        return {};
     }
 
     void Document::AddPtr(std::unique_ptr<Object>&& obj) {
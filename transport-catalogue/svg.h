@@ -180,7 +180,7 @@ namespace svg {
         void RenderObject(const RenderContext& context) const override;
 
         std::string ConvertTextToSVG() const;
-        void ConvertSymbolToSVG(std::string& text, char symbol) const;
+        static std::string_view ConvertSymbolToSVG(char symbol);
 
         Point pos_;
         Point offset_;
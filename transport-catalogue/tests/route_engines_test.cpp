@@ -0,0 +1,384 @@
+// Проверяет, что все движки маршрутизации печатают побайтно одинаковые
+// ответы на один и тот же вход: одинаковые items и одинаковый total_time
+// вплоть до последней цифры. Затем то же на сети, где у части автобусов
+// есть расписание, а половина запросов с departure_time: такие запросы
+// сверяются ещё и с поиском Дейкстры с зависящими от времени рёбрами.
+//
+// Сборка из каталога tests (graph.h, router.h и ranges.h лежат рядом с
+// остальными исходниками):
+//   g++ -std=c++17 -O2 -pthread -I.. route_engines_test.cpp $(ls ../*.cpp | grep -v main.cpp) -o route_engines_test
+// Запуск: ./route_engines_test [число остановок]
+
+#include "json.h"
+#include "json_reader.h"
+#include "map_renderer.h"
+#include "transport_catalogue.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+    using namespace std::literals;
+
+    constexpr int BUS_WAIT_TIME = 6;
+    constexpr int BUS_VELOCITY = 37;
+    constexpr double NOT_REACHED = std::numeric_limits<double>::infinity();
+
+    // Сеть без равноценных маршрутов: каждую пару соседних остановок
+    // проезжает один автобус, остановки внутри автобуса не повторяются,
+    // а расстояния случайные и разные, так что у любого запроса один
+    // кратчайший маршрут и движки обязаны найти одни и те же items.
+    // Все автобусы некольцевые
+    struct Network {
+        size_t stop_count = 0;
+        std::vector<std::pair<uint32_t, uint32_t>> coordinates;
+        std::vector<std::vector<size_t>> buses;
+        // Расстояния, заданные у остановки: в обратную сторону то же
+        std::vector<std::vector<std::pair<size_t, uint32_t>>> distances;
+        // Отправления с первой остановки, пусто - расписания нет
+        std::vector<std::vector<double>> departures;
+        // Расписание задано через first_departure, last_departure и headway
+        std::vector<bool> has_headway;
+    };
+
+    Network MakeNetwork(size_t stop_count, bool with_timetables) {
+        uint64_t state = 7;
+        auto next = [&state] {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<uint32_t>(state >> 33);
+        };
+
+        Network network;
+        network.stop_count = stop_count;
+        network.distances.resize(stop_count);
+        std::set<std::pair<size_t, size_t>> used_pairs;
+        const size_t bus_count = stop_count / 3 + 1;
+        for (size_t bus = 0; bus < bus_count; ++bus) {
+            std::vector<size_t> stops{ next() % stop_count };
+            for (size_t attempt = 0; attempt < 30 && stops.size() < 7; ++attempt) {
+                const size_t stop = next() % stop_count;
+                const auto pair = std::minmax(stops.back(), stop);
+                bool repeated = false;
+                for (const size_t visited : stops) {
+                    repeated = repeated || visited == stop;
+                }
+                if (repeated || used_pairs.count(pair) > 0) {
+                    continue;
+                }
+                used_pairs.insert(pair);
+                network.distances[stops.back()].push_back({ stop, 1000 + next() % 99000 });
+                stops.push_back(stop);
+            }
+            if (stops.size() > 1) {
+                network.buses.push_back(std::move(stops));
+            }
+        }
+        for (size_t stop = 0; stop < stop_count; ++stop) {
+            network.coordinates.push_back({ 500000 + next() % 200000, 500000 + next() % 200000 });
+        }
+
+        // Каждый второй автобус ходит по расписанию: половина из них с
+        // интервалом, половина со списком отправлений вразнобой
+        network.departures.resize(network.buses.size());
+        network.has_headway.resize(network.buses.size());
+        for (size_t bus = 0; with_timetables && bus < network.buses.size(); bus += 2) {
+            std::vector<double>& departures = network.departures[bus];
+            if (bus % 4 == 0) {
+                const uint32_t first = 240 + next() % 240;
+                const uint32_t headway = 5 + next() % 25;
+                const uint32_t trip_count = 10 + next() % 40;
+                for (uint32_t trip = 0; trip < trip_count; ++trip) {
+                    departures.push_back(first + trip * headway);
+                }
+                network.has_headway[bus] = true;
+                continue;
+            }
+            for (size_t trip = 0, trip_count = 1 + next() % 12; trip < trip_count; ++trip) {
+                departures.push_back((next() % 2880) / 2.0);
+            }
+        }
+        return network;
+    }
+
+    std::string StopName(size_t stop) {
+        return "Stop " + std::to_string(stop);
+    }
+
+    std::string MakeInput(const Network& network, std::string_view engine) {
+        uint64_t state = 11;
+        auto next = [&state] {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<uint32_t>(state >> 33);
+        };
+        bool with_timetables = false;
+        for (const std::vector<double>& departures : network.departures) {
+            with_timetables = with_timetables || !departures.empty();
+        }
+
+        std::string out = "{\"base_requests\": [\n";
+        for (size_t stop = 0; stop < network.stop_count; ++stop) {
+            out += "{\"type\": \"Stop\", \"name\": \"" + StopName(stop) + "\", \"latitude\": 55.";
+            out += std::to_string(network.coordinates[stop].first);
+            out += ", \"longitude\": 37.";
+            out += std::to_string(network.coordinates[stop].second);
+            out += ", \"road_distances\": {";
+            for (size_t i = 0; i < network.distances[stop].size(); ++i) {
+                out += (i > 0 ? ", \""s : "\""s) + StopName(network.distances[stop][i].first) + "\": ";
+                out += std::to_string(network.distances[stop][i].second);
+            }
+            out += "}},\n";
+        }
+        for (size_t bus = 0; bus < network.buses.size(); ++bus) {
+            out += "{\"type\": \"Bus\", \"name\": \"Bus " + std::to_string(bus) + "\", \"is_roundtrip\": false, \"stops\": [";
+            for (size_t i = 0; i < network.buses[bus].size(); ++i) {
+                out += (i > 0 ? ", \""s : "\""s) + StopName(network.buses[bus][i]) + "\"";
+            }
+            out += "]";
+            const std::vector<double>& departures = network.departures[bus];
+            if (network.has_headway[bus]) {
+                out += ", \"timetable\": {\"first_departure\": " + std::to_string(departures.front())
+                    + ", \"last_departure\": " + std::to_string(departures.back())
+                    + ", \"headway\": " + std::to_string(departures[1] - departures[0]) + "}";
+            }
+            else if (!departures.empty()) {
+                out += ", \"timetable\": {\"departures\": [";
+                for (size_t i = 0; i < departures.size(); ++i) {
+                    out += (i > 0 ? ", "s : ""s) + std::to_string(departures[i]);
+                }
+                out += "]}";
+            }
+            out += (bus + 1 < network.buses.size()) ? "},\n" : "}\n";
+        }
+        out += "],\n\"render_settings\": {\"width\": 1200, \"height\": 1200, \"padding\": 50, "
+            "\"line_width\": 14, \"stop_radius\": 5, \"bus_label_font_size\": 20, "
+            "\"bus_label_offset\": [7, 15], \"stop_label_font_size\": 20, "
+            "\"stop_label_offset\": [7, -3], \"underlayer_color\": [255, 255, 255, 0.85], "
+            "\"underlayer_width\": 3, \"color_palette\": [\"green\", [255, 160, 0], \"red\"]},\n"
+            "\"routing_settings\": {\"bus_wait_time\": " + std::to_string(BUS_WAIT_TIME)
+            + ", \"bus_velocity\": " + std::to_string(BUS_VELOCITY) + ", \"engine\": \"";
+        out += engine;
+        out += "\"},\n\"stat_requests\": [\n";
+        size_t id = 0;
+        for (size_t from = 0; from < network.stop_count; ++from) {
+            for (size_t to = 0; to < network.stop_count; ++to) {
+                out += id > 0 ? ",\n"s : ""s;
+                out += "{\"id\": " + std::to_string(id) + ", \"type\": \"Route\", \"from\": \""
+                    + StopName(from) + "\", \"to\": \"" + StopName(to) + "\"";
+                // Чётные запросы с departure_time, в том числе до первых и
+                // после последних отправлений
+                if (with_timetables && id % 2 == 0) {
+                    out += ", \"departure_time\": " + std::to_string((next() % 3600) / 2.0);
+                }
+                out += "}";
+                ++id;
+            }
+        }
+        out += "\n]}\n";
+        return out;
+    }
+
+    std::string Answer(const Network& network, std::string_view engine) {
+        catalogue::TransportCatalogue catalogue;
+        catalogue::renderer::MapRenderer map_renderer(catalogue);
+        catalogue::JSONReader json_reader(catalogue, map_renderer);
+        std::istringstream input(MakeInput(network, engine));
+        std::ostringstream output;
+        {
+            json::Writer writer(output, json::Format::PRETTY);
+            json_reader.ProcessRequests(input, writer);
+        }
+        return output.str();
+    }
+
+    // Сравнивает ответы движков с ответом all_pairs, true - все совпали
+    bool CompareEngines(const Network& network, const std::string& expected) {
+        bool failed = false;
+        for (const std::string_view engine : { "dijkstra"sv, "contraction_hierarchies"sv, "a_star"sv, "alt"sv, "raptor"sv }) {
+            const std::string answer = Answer(network, engine);
+            if (answer == expected) {
+                std::cout << engine << ": OK\n"sv;
+                continue;
+            }
+            failed = true;
+            size_t pos = 0;
+            while (pos < answer.size() && pos < expected.size() && answer[pos] == expected[pos]) {
+                ++pos;
+            }
+            const size_t begin = pos > 200 ? pos - 200 : 0;
+            std::cout << engine << ": differs from all_pairs at byte "sv << pos << "\n  all_pairs: "sv
+                << expected.substr(begin, 300) << "\n  "sv << engine << ": "sv << answer.substr(begin, 300) << '\n';
+        }
+        return !failed;
+    }
+
+    // Самое раннее прибытие на каждую остановку при отправлении из from в
+    // момент departure: Дейкстра, где рёбра - поездки от остановки до любой
+    // из следующих. Рейс по расписанию идёт через все остановки туда и
+    // обратно, на него садятся, когда он отходит. На автобус без расписания
+    // садятся через BUS_WAIT_TIME в любом из двух направлений
+    std::vector<double> EarliestArrivals(const Network& network, size_t from, double departure) {
+        const double velocity = double(BUS_VELOCITY) * 1000 / 60;
+        std::map<std::pair<size_t, size_t>, uint64_t> distances;
+        for (size_t stop = 0; stop < network.stop_count; ++stop) {
+            for (const auto& [to, distance] : network.distances[stop]) {
+                distances[{ stop, to }] = distance;
+                distances[{ to, stop }] = distance;
+            }
+        }
+        // Расстояния от первой остановки последовательности до каждой из
+        // них: время в пути считается по ним так же, как в движке
+        auto make_distances = [&](const std::vector<size_t>& stops) {
+            std::vector<uint64_t> result(stops.size());
+            for (size_t i = 1; i < stops.size(); ++i) {
+                result[i] = result[i - 1] + distances.at({ stops[i - 1], stops[i] });
+            }
+            return result;
+        };
+
+        std::vector<double> arrivals(network.stop_count, NOT_REACHED);
+        std::vector<bool> is_settled(network.stop_count);
+        using Item = std::pair<double, size_t>;
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+        arrivals[from] = departure;
+        queue.push({ departure, from });
+        auto relax = [&](size_t stop, double arrival) {
+            if (arrival < arrivals[stop]) {
+                arrivals[stop] = arrival;
+                queue.push({ arrival, stop });
+            }
+        };
+
+        while (!queue.empty()) {
+            const auto [time, stop] = queue.top();
+            queue.pop();
+            if (is_settled[stop]) {
+                continue;
+            }
+            is_settled[stop] = true;
+
+            for (size_t bus = 0; bus < network.buses.size(); ++bus) {
+                const std::vector<size_t>& forward = network.buses[bus];
+                const std::vector<size_t> backward(forward.rbegin(), forward.rend());
+                const std::vector<double>& departures = network.departures[bus];
+                if (departures.empty()) {
+                    for (const std::vector<size_t>* stops : { &forward, &backward }) {
+                        const std::vector<uint64_t> path = make_distances(*stops);
+                        const size_t board = std::find(stops->begin(), stops->end(), stop) - stops->begin();
+                        for (size_t alight = board + 1; alight < stops->size(); ++alight) {
+                            relax((*stops)[alight], time + BUS_WAIT_TIME + double(path[alight] - path[board]) / velocity);
+                        }
+                    }
+                    continue;
+                }
+
+                std::vector<size_t> trip = forward;
+                trip.insert(trip.end(), backward.begin() + 1, backward.end());
+                const std::vector<uint64_t> path = make_distances(trip);
+                std::vector<double> offsets(trip.size());
+                for (size_t i = 0; i < trip.size(); ++i) {
+                    offsets[i] = double(path[i]) / velocity;
+                }
+                std::vector<double> sorted_departures = departures;
+                std::sort(sorted_departures.begin(), sorted_departures.end());
+                for (size_t board = 0; board + 1 < trip.size(); ++board) {
+                    if (trip[board] != stop) {
+                        continue;
+                    }
+                    // У всех рейсов одни и те же времена в пути, поэтому
+                    // первый отходящий рейс приезжает раньше остальных
+                    for (const double trip_departure : sorted_departures) {
+                        if (trip_departure + offsets[board] < time) {
+                            continue;
+                        }
+                        for (size_t alight = board + 1; alight < trip.size(); ++alight) {
+                            relax(trip[alight], trip_departure + offsets[alight]);
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+        return arrivals;
+    }
+
+    // Сверяет total_time запросов с departure_time с поиском Дейкстры
+    bool CheckTimedRoutes(const Network& network, const std::string& answer) {
+        std::istringstream input(MakeInput(network, "all_pairs"sv));
+        const json::Document requests = json::Load(input);
+        std::istringstream answer_input(answer);
+        const json::Document answers = json::Load(answer_input);
+
+        size_t checked = 0;
+        size_t found = 0;
+        size_t mismatches = 0;
+        std::map<std::pair<size_t, double>, std::vector<double>> arrivals_cache;
+        const json::Array& stat_requests = requests.GetRoot().AsDict().at("stat_requests").AsArray();
+        for (size_t i = 0; i < stat_requests.size(); ++i) {
+            const json::Dict& request = stat_requests[i].AsDict();
+            const auto departure_it = request.find("departure_time");
+            if (departure_it == request.end()) {
+                continue;
+            }
+            const double departure = departure_it->second.AsDouble();
+            const size_t from = std::stoul(std::string(request.at("from").AsString().substr("Stop "sv.size())));
+            const size_t to = std::stoul(std::string(request.at("to").AsString().substr("Stop "sv.size())));
+            auto it = arrivals_cache.find({ from, departure });
+            if (it == arrivals_cache.end()) {
+                it = arrivals_cache.emplace(std::pair{ from, departure },
+                    EarliestArrivals(network, from, departure)).first;
+            }
+            const double expected = it->second[to] - departure;
+
+            const json::Dict& route = answers.GetRoot().AsArray()[i].AsDict();
+            const auto total_it = route.find("total_time");
+            const double total_time = total_it == route.end() ? NOT_REACHED : total_it->second.AsDouble();
+            ++checked;
+            found += total_it != route.end();
+            if (total_time == expected || std::abs(total_time - expected) < 1e-9) {
+                continue;
+            }
+            if (++mismatches <= 5) {
+                std::cout << "  request "sv << i << " from "sv << from << " to "sv << to << " at "sv << departure
+                    << ": total_time "sv << total_time << ", expected "sv << expected << '\n';
+            }
+        }
+        std::cout << "departure_time: "sv << checked << " requests, "sv << found << " found, "sv
+            << mismatches << " mismatches\n"sv;
+        return checked > 0 && found > 0 && mismatches == 0;
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t stop_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 60;
+    const Network network = MakeNetwork(stop_count, false);
+    const std::string expected = Answer(network, "all_pairs"sv);
+    if (expected.find("\"items\""sv) == std::string::npos) {
+        std::cerr << "no route was found"sv << std::endl;
+        return 1;
+    }
+    bool failed = !CompareEngines(network, expected);
+
+    // Запросы с departure_time ищутся по расписаниям одинаково при любом
+    // движке, а без него движки по-прежнему должны совпадать
+    std::cout << "with timetables:\n"sv;
+    const Network timed_network = MakeNetwork(stop_count, true);
+    const std::string timed_expected = Answer(timed_network, "all_pairs"sv);
+    failed = !CheckTimedRoutes(timed_network, timed_expected) || failed;
+    failed = !CompareEngines(timed_network, timed_expected) || failed;
+    return failed ? 1 : 0;
+}
@@ -2,54 +2,123 @@
 #include "geo.h"
 
 #include <algorithm>
-#include <numeric>
-#include <unordered_set>
-#include <unordered_map>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
 #include <string_view>
 
 
 namespace catalogue {
 
-	using InfoMain = std::vector<Stop>;
-	using InfoSecondary = std::unordered_map<std::string, std::string>;
+	namespace {
+		bool NameLess(std::string_view lhs, std::string_view rhs) {
+			return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+		}
+	}
+
+	// Names are unique, so the order does not depend on the sort
+	void TransportCatalogue::SortByName(const NamePool& names, std::vector<uint32_t>& sorted_ids,
+		std::vector<uint64_t>& ranks) {
+		std::sort(sorted_ids.begin(), sorted_ids.end(),
+			[&names](uint32_t l, uint32_t r) { return NameLess(names.Get(l), names.Get(r)); });
+		ranks.resize(sorted_ids.size());
+		for (size_t position = 0; position < sorted_ids.size(); ++position) {
+			ranks[sorted_ids[position]] = position;
+		}
+	}
 
-	void TransportCatalogue::AddStop(const Stop& stop) {
-		stops_.push_back(stop);
-		const Stop* stop_ptr = &stops_[stops_.size() - 1];
-		stop_to_ptr_stop_.insert({ stop_ptr->name, stop_ptr });
+	void TransportCatalogue::UpdateStopIndex() const {
+		if (is_stop_index_stale_) {
+			SortByName(stop_names_, stops_by_name_, stop_name_ranks_);
+			is_stop_index_stale_ = false;
+		}
+	}
 
-		if (!stop_to_buses_.count(FindStop(stop.name))) {
-			stop_to_buses_[stop_ptr];
+	void TransportCatalogue::UpdateBusIndex() const {
+		if (!is_bus_index_stale_) {
+			return;
+		}
+		SortByName(bus_names_, buses_by_name_, bus_name_ranks_);
+		for (std::vector<BusId>& buses : stop_to_buses_) {
+			std::sort(buses.begin(), buses.end(),
+				[this](BusId l, BusId r) { return bus_name_ranks_[l] < bus_name_ranks_[r]; });
 		}
+		is_bus_index_stale_ = false;
 	}
 
-	void TransportCatalogue::AddBus(const Bus& bus) {
-		buses_.push_back(bus);
-		const Bus* bus_ptr = &buses_[buses_.size() - 1];
-		bus_to_ptr_bus_.insert({ bus_ptr->name, bus_ptr });
+	StopId TransportCatalogue::AddStop(const Stop& stop) {
+		const auto [id, is_new] = stop_names_.Intern(stop.name);
+		if (!is_new) {
+			return id;
+		}
 
-		for (const Stop* stop_ptr : bus.stops) {
-			if (stop_to_buses_.count(stop_ptr)) {
-				stop_to_buses_.at(stop_ptr).insert(bus_ptr);
-			}
-			else {
-				stop_to_buses_[stop_ptr].insert(bus_ptr);
+		stop_latitudes_.push_back(stop.coordinate.lat);
+		stop_longitudes_.push_back(stop.coordinate.lng);
+		stop_to_buses_.emplace_back();
+		stops_by_name_.push_back(id);
+		is_stop_index_stale_ = true;
+
+		return id;
+	}
+
+	BusId TransportCatalogue::AddBus(const Bus& bus) {
+		const auto [id, is_new] = bus_names_.Intern(bus.name);
+		if (!is_new) {
+			return id;
+		}
+
+		bus_types_.push_back(bus.type_route);
+		bus_stops_.insert(bus_stops_.end(), bus.stops.begin(), bus.stops.end());
+		bus_stop_offsets_.push_back(bus_stops_.size());
+		bus_departures_.insert(bus_departures_.end(), bus.departures.begin(), bus.departures.end());
+		bus_departure_offsets_.push_back(bus_departures_.size());
+		buses_by_name_.push_back(id);
+		is_bus_index_stale_ = true;
+		bus_stats_.push_back({ CalculateUniqueStops(id), CalculateGeoLenghtRoute(id),
+			CalculateFactLenghtRoute(id) });
+
+		// The new bus is the last one added to the list of each of its
+		// stops, so a stop visited again is found at the back
+		for (StopId stop : bus.stops) {
+			std::vector<BusId>& buses = stop_to_buses_.at(stop);
+			if (buses.empty() || buses.back() != id) {
+				buses.push_back(id);
 			}
 		}
+
+		return id;
 	}
 
-	const Bus* TransportCatalogue::FindBus(std::string_view bus) const {
-		return (bus_to_ptr_bus_.count(bus)) ? bus_to_ptr_bus_.at(bus) : nullptr;
+	std::optional<BusId> TransportCatalogue::FindBus(std::string_view bus) const {
+		return bus_names_.Find(bus);
 	}
 
-	const Stop* TransportCatalogue::FindStop(std::string_view stop) const {
-		return (stop_to_ptr_stop_.count(stop)) ? stop_to_ptr_stop_.at(stop) : nullptr;
+	std::optional<StopId> TransportCatalogue::FindStop(std::string_view stop) const {
+		return stop_names_.Find(stop);
 	}
 
 	void TransportCatalogue::SetDistance(std::string_view from, std::string_view to, size_t distance) {
+		const auto from_id = FindStop(from);
+		const auto to_id = FindStop(to);
+		if (from_id && to_id) {
+			SetDistance(*from_id, *to_id, distance);
+		}
+	}
 
-		if (!distances_.count({ FindStop(from), FindStop(to) })) {
-			distances_.insert({ {FindStop(from), FindStop(to)}, distance });
+	void TransportCatalogue::SetDistance(StopId from, StopId to, size_t distance) {
+		if (from >= GetStopCount() || to >= GetStopCount()) {
+			throw std::out_of_range("unknown stop");
+		}
+		if (!distances_.Set(from, to, distance)) {
+			return;
+		}
+
+		// Only a route passing through from can have the segment from-to
+		// in either direction
+		for (BusId bus : stop_to_buses_.at(from)) {
+			bus_stats_[bus].route_length = CalculateFactLenghtRoute(bus);
 		}
 	}
 
@@ -57,13 +126,17 @@ namespace catalogue {
 
 		BusInfo bus_info;
 
-		if (bus_to_ptr_bus_.count(bus)) {
+		if (auto id = FindBus(bus)) {
+			const BusStats& stats = bus_stats_[*id];
+			if (!stats.route_length) {
+				throw std::out_of_range("unknown distance");
+			}
 			bus_info.bus_is_existing = true;
-			bus_info.name = FindBus(bus)->name;
-			bus_info.number_stops = bus_to_ptr_bus_.at(bus)->stops.size();
-			bus_info.unique_stops = CalculateUniqueStops(bus);
-			bus_info.length_route = CalculateFactLenghtRoute(bus);
-			bus_info.curvature = bus_info.length_route / CalculateGeoLenghtRoute(bus);
+			bus_info.name = GetBusName(*id);
+			bus_info.number_stops = GetBusStops(*id).size();
+			bus_info.unique_stops = stats.unique_stops;
+			bus_info.length_route = *stats.route_length;
+			bus_info.curvature = bus_info.length_route / stats.geo_length;
 		}
 		else {
 			bus_info.name = std::string(bus);
@@ -73,84 +146,270 @@ namespace catalogue {
 	}
 
 	StopInfo TransportCatalogue::GetStopInfo(std::string_view stop) const {
-		if (stop_to_buses_.count(FindStop(stop))) {
-			return { true, std::string(stop), stop_to_buses_.at(FindStop(stop)) };
+		if (auto id = FindStop(stop)) {
+			return { true, GetStopName(*id), GetBusesByStop(*id) };
 		}
 
-		return { false, std::string(stop), {} };
+		return { false, stop, {} };
 	}
 
-	size_t TransportCatalogue::GetDistance(std::string_view from, std::string_view to) const {
-
-		if (distances_.count({ FindStop(from), FindStop(to) })) {
-			return distances_.at({ FindStop(from), FindStop(to) });
+	size_t TransportCatalogue::GetDistance(StopId from, StopId to) const {
+		if (const auto distance = distances_.Find(from, to)) {
+			return *distance;
 		}
+		throw std::out_of_range("unknown distance");
+	}
 
-		return distances_.at({ FindStop(to), FindStop(from) });
+	size_t TransportCatalogue::GetStopCount() const {
+		return stop_names_.Size();
 	}
 
-	class HasherUnique {
-	public:
-		size_t operator()(const Stop* stop) const {
-			return hasher_(stop);
-		}
+	std::string_view TransportCatalogue::GetStopName(StopId stop) const {
+		return stop_names_.Get(stop);
+	}
+
+	geo::Coordinates TransportCatalogue::GetStopCoordinates(StopId stop) const {
+		return { stop_latitudes_.at(stop), stop_longitudes_.at(stop) };
+	}
 
-	private:
-		std::hash<const Stop*> hasher_;
-	};
+	IdSpan<BusId> TransportCatalogue::GetBusesByStop(StopId stop) const {
+		UpdateBusIndex();
+		const std::vector<BusId>& buses = stop_to_buses_.at(stop);
+		return { buses.data(), buses.data() + buses.size() };
+	}
 
-	size_t TransportCatalogue::CalculateUniqueStops(std::string_view bus) const {
-		std::unordered_set<const Stop*, HasherUnique> tmp;
+	size_t TransportCatalogue::GetBusCount() const {
+		return bus_names_.Size();
+	}
 
-		for (const Stop* stop : FindBus(bus)->stops) {
-			if (!tmp.count(stop)) {
-				tmp.insert(stop);
-			}
-		}
+	std::string_view TransportCatalogue::GetBusName(BusId bus) const {
+		return bus_names_.Get(bus);
+	}
+
+	TypeRoute TransportCatalogue::GetBusType(BusId bus) const {
+		return bus_types_.at(bus);
+	}
+
+	IdSpan<StopId> TransportCatalogue::GetBusStops(BusId bus) const {
+		const StopId* stops = bus_stops_.data();
+		return { stops + bus_stop_offsets_.at(bus), stops + bus_stop_offsets_.at(bus + 1) };
+	}
 
-		return tmp.size();
+	IdSpan<double> TransportCatalogue::GetBusDepartures(BusId bus) const {
+		const double* departures = bus_departures_.data();
+		return { departures + bus_departure_offsets_.at(bus), departures + bus_departure_offsets_.at(bus + 1) };
 	}
 
-	double TransportCatalogue::CalculateFactLenghtRoute(std::string_view bus) const {
+	bool TransportCatalogue::HasDepartures() const {
+		return !bus_departures_.empty();
+	}
+
+	size_t TransportCatalogue::CalculateUniqueStops(BusId bus) const {
+		std::vector<StopId> stops(GetBusStops(bus).begin(), GetBusStops(bus).end());
+		std::sort(stops.begin(), stops.end());
+
+		return std::unique(stops.begin(), stops.end()) - stops.begin();
+	}
+
+	std::optional<double> TransportCatalogue::CalculateFactLenghtRoute(BusId bus) const {
 		double distance = 0;
 
-		auto from = FindBus(bus)->stops.begin();
-		for (auto to = std::next(from); to != FindBus(bus)->stops.end(); ++to) {
-			distance += GetDistance((*from)->name, (*to)->name);
-			from = to;
+		const IdSpan<StopId> stops = GetBusStops(bus);
+		for (size_t n = 1; n < stops.size(); ++n) {
+			const auto segment = distances_.Find(stops[n - 1], stops[n]);
+			if (!segment) {
+				return std::nullopt;
+			}
+			distance += *segment;
 		}
 
 		return distance;
 	}
 
-	double TransportCatalogue::CalculateGeoLenghtRoute(std::string_view bus) const {
+	double TransportCatalogue::CalculateGeoLenghtRoute(BusId bus) const {
 		double distance = 0;
 
-		geo::Coordinates from = { FindBus(bus)->stops[0]->coordinate.lat, FindBus(bus)->stops[0]->coordinate.lng };
-
-		for (size_t n = 1; n < FindBus(bus)->stops.size(); ++n) {
-			auto stop = FindBus(bus)->stops[n];
-			geo::Coordinates to{ stop->coordinate.lat, stop->coordinate.lng };
-			distance += ComputeDistance(from, to);
-			from = to;
+		const IdSpan<StopId> stops = GetBusStops(bus);
+		for (size_t n = 1; n < stops.size(); ++n) {
+			distance += ComputeDistance(GetStopCoordinates(stops[n - 1]), GetStopCoordinates(stops[n]));
 		}
 		return distance;
 	}
 
-	const std::unordered_set<const Bus*> TransportCatalogue::GetAllBuses() const {
-		std::unordered_set<const Bus*> buses;
-		for (const auto& [_, bus_ptr] : bus_to_ptr_bus_) {
-			buses.insert(bus_ptr);
+	uint64_t TransportCatalogue::GetStopNameRank(StopId stop) const {
+		UpdateStopIndex();
+		return stop_name_ranks_.at(stop);
+	}
+
+	uint64_t TransportCatalogue::GetBusNameRank(BusId bus) const {
+		UpdateBusIndex();
+		return bus_name_ranks_.at(bus);
+	}
+
+	IdSpan<BusId> TransportCatalogue::GetAllBuses() const {
+		UpdateBusIndex();
+		return { buses_by_name_.data(), buses_by_name_.data() + buses_by_name_.size() };
+	}
+
+	IdSpan<StopId> TransportCatalogue::GetAllStops() const {
+		UpdateStopIndex();
+		return { stops_by_name_.data(), stops_by_name_.data() + stops_by_name_.size() };
+	}
+
+	namespace {
+		template <typename Id>
+		bool AreValidIds(const std::vector<Id>& ids, size_t count) {
+			return std::all_of(ids.begin(), ids.end(), [count](Id id) { return id < count; });
+		}
+
+		// Offsets into an array of size size, starting at 0 and not decreasing
+		bool AreValidOffsets(const std::vector<uint64_t>& offsets, size_t count, size_t size) {
+			return offsets.size() == count + 1 && offsets.front() == 0 && offsets.back() == size
+				&& std::is_sorted(offsets.begin(), offsets.end());
+		}
+
+		// The rank of every id is its position in the index
+		bool AreValidRanks(const std::vector<uint32_t>& sorted_ids, const std::vector<uint64_t>& ranks) {
+			if (ranks.size() != sorted_ids.size()) {
+				return false;
+			}
+			for (size_t position = 0; position < sorted_ids.size(); ++position) {
+				if (ranks[sorted_ids[position]] != position) {
+					return false;
+				}
+			}
+			return true;
+		}
+	}
+
+	void TransportCatalogue::Save(snapshot::Writer& writer) const {
+		UpdateStopIndex();
+		UpdateBusIndex();
+		stop_names_.Save(writer);
+		writer.Write(stop_name_ranks_);
+		writer.Write(stop_latitudes_);
+		writer.Write(stop_longitudes_);
+
+		std::vector<uint64_t> stop_bus_offsets = { 0 };
+		std::vector<BusId> stop_buses;
+		for (const std::vector<BusId>& buses : stop_to_buses_) {
+			stop_buses.insert(stop_buses.end(), buses.begin(), buses.end());
+			stop_bus_offsets.push_back(stop_buses.size());
+		}
+		writer.Write(stop_bus_offsets);
+		writer.Write(stop_buses);
+		distances_.Save(writer);
+		writer.Write(stops_by_name_);
+
+		bus_names_.Save(writer);
+		writer.Write(bus_name_ranks_);
+		writer.Write(bus_types_);
+		writer.Write(std::vector<uint64_t>(bus_stop_offsets_.begin(), bus_stop_offsets_.end()));
+		writer.Write(bus_stops_);
+		writer.Write(std::vector<uint64_t>(bus_departure_offsets_.begin(), bus_departure_offsets_.end()));
+		writer.Write(bus_departures_);
+		writer.Write(buses_by_name_);
+
+		std::vector<uint64_t> unique_stops;
+		std::vector<double> geo_lengths;
+		std::vector<double> route_lengths;
+		for (const BusStats& stats : bus_stats_) {
+			unique_stops.push_back(stats.unique_stops);
+			geo_lengths.push_back(stats.geo_length);
+			route_lengths.push_back(stats.route_length.value_or(std::numeric_limits<double>::quiet_NaN()));
 		}
-		return buses;
+		writer.Write(unique_stops);
+		writer.Write(geo_lengths);
+		writer.Write(route_lengths);
 	}
 
-	const std::unordered_set<const Stop*> TransportCatalogue::GetAllStops() const {
-		std::unordered_set<const Stop*> stops;
-		for (const auto& [_, stop_ptr] : stop_to_ptr_stop_) {
-			stops.insert(stop_ptr);
+	void TransportCatalogue::Load(snapshot::Reader& reader) {
+		stop_names_.Load(reader);
+		reader.Read(stop_name_ranks_);
+		reader.Read(stop_latitudes_);
+		reader.Read(stop_longitudes_);
+
+		std::vector<uint64_t> stop_bus_offsets;
+		std::vector<BusId> stop_buses;
+		reader.Read(stop_bus_offsets);
+		reader.Read(stop_buses);
+		distances_.Load(reader);
+		reader.Read(stops_by_name_);
+
+		bus_names_.Load(reader);
+		reader.Read(bus_name_ranks_);
+		reader.Read(bus_types_);
+		std::vector<uint64_t> bus_stop_offsets;
+		reader.Read(bus_stop_offsets);
+		reader.Read(bus_stops_);
+		std::vector<uint64_t> bus_departure_offsets;
+		reader.Read(bus_departure_offsets);
+		reader.Read(bus_departures_);
+		reader.Read(buses_by_name_);
+
+		std::vector<uint64_t> unique_stops;
+		std::vector<double> geo_lengths;
+		std::vector<double> route_lengths;
+		reader.Read(unique_stops);
+		reader.Read(geo_lengths);
+		reader.Read(route_lengths);
+
+		const size_t stop_count = GetStopCount();
+		const size_t bus_count = GetBusCount();
+		const bool is_valid =
+			stop_latitudes_.size() == stop_count
+			&& stop_longitudes_.size() == stop_count
+			&& stops_by_name_.size() == stop_count && AreValidIds(stops_by_name_, stop_count)
+			&& AreValidRanks(stops_by_name_, stop_name_ranks_)
+			&& AreValidOffsets(stop_bus_offsets, stop_count, stop_buses.size())
+			&& AreValidIds(stop_buses, bus_count)
+			&& bus_types_.size() == bus_count
+			&& AreValidOffsets(bus_stop_offsets, bus_count, bus_stops_.size())
+			&& AreValidIds(bus_stops_, stop_count)
+			&& AreValidOffsets(bus_departure_offsets, bus_count, bus_departures_.size())
+			&& buses_by_name_.size() == bus_count && AreValidIds(buses_by_name_, bus_count)
+			&& AreValidRanks(buses_by_name_, bus_name_ranks_)
+			&& unique_stops.size() == bus_count
+			&& geo_lengths.size() == bus_count
+			&& route_lengths.size() == bus_count;
+		if (!is_valid) {
+			throw snapshot::SnapshotError("catalogue arrays in snapshot do not match");
+		}
+		is_stop_index_stale_ = false;
+		is_bus_index_stale_ = false;
+
+		stop_to_buses_.assign(stop_count, {});
+		for (StopId stop = 0; stop < stop_count; ++stop) {
+			stop_to_buses_[stop].assign(stop_buses.begin() + stop_bus_offsets[stop],
+				stop_buses.begin() + stop_bus_offsets[stop + 1]);
 		}
-		return stops;
+		bus_stop_offsets_.assign(bus_stop_offsets.begin(), bus_stop_offsets.end());
+		bus_departure_offsets_.assign(bus_departure_offsets.begin(), bus_departure_offsets.end());
+
+		bus_stats_.resize(bus_count);
+		for (BusId bus = 0; bus < bus_count; ++bus) {
+			bus_stats_[bus].unique_stops = unique_stops[bus];
+			bus_stats_[bus].geo_length = geo_lengths[bus];
+			bus_stats_[bus].route_length = std::isnan(route_lengths[bus])
+				? std::nullopt
+				: std::optional<double>(route_lengths[bus]);
+		}
+	}
+
+	CompareBuses::CompareBuses(const TransportCatalogue& catalogue)
+		: catalogue_(catalogue) {
+	}
+
+	bool CompareBuses::operator()(BusId l, BusId r) const {
+		return catalogue_.GetBusNameRank(l) < catalogue_.GetBusNameRank(r);
+	}
+
+	CompareStop::CompareStop(const TransportCatalogue& catalogue)
+		: catalogue_(catalogue) {
+	}
+
+	bool CompareStop::operator()(StopId l, StopId r) const {
+		return catalogue_.GetStopNameRank(l) < catalogue_.GetStopNameRank(r);
 	}
 
 } // namespace catalogue
@@ -1,57 +1,132 @@
 #pragma once
 
-#include <deque>
 #include <string>
-#include <unordered_map>
 #include <vector>
 #include <string_view>
-#include <set>
-#include <functional>
-#include <variant>
+#include <optional>
+#include <utility>
 
 #include "domain.h"
+#include "name_pool.h"
+#include "road_distances.h"
+#include "snapshot.h"
 
 namespace catalogue {
 	class TransportCatalogue {
-		using InfoMain = std::vector<Stop>;
-		using InfoSecondary = std::unordered_map<std::string, std::string>;
-
 	public:
-		void AddStop(const Stop& stop);
-		void AddBus(const Bus& bus);
+		// A stop or bus whose name is already known keeps its first id
+		StopId AddStop(const Stop& stop);
+		BusId AddBus(const Bus& bus);
 
-		const Bus* FindBus(std::string_view bus) const;
-		const Stop* FindStop(std::string_view stop) const;
+		std::optional<BusId> FindBus(std::string_view bus) const;
+		std::optional<StopId> FindStop(std::string_view stop) const;
 
+		// Buses through from get their route length recomputed
 		void SetDistance(std::string_view from, std::string_view to, size_t distance);
+		void SetDistance(StopId from, StopId to, size_t distance);
 
+		// Statistics are computed when the bus is added and kept up to date
+		// by SetDistance. Throws std::out_of_range if a distance of the route
+		// is still unknown
 		BusInfo GetBusInfo(std::string_view bus) const;
 		StopInfo GetStopInfo(std::string_view stop) const;
-		size_t GetDistance(std::string_view from, std::string_view to) const;
-		const std::unordered_set<const Bus*> GetAllBuses() const;
-		const std::unordered_set<const Stop*> GetAllStops() const;
+
+		// Falls back to the distance in the opposite direction
+		size_t GetDistance(StopId from, StopId to) const;
+
+		// Names stay valid until the next stop or bus is added
+		size_t GetStopCount() const;
+		std::string_view GetStopName(StopId stop) const;
+		geo::Coordinates GetStopCoordinates(StopId stop) const;
+		// Sorted by bus name
+		IdSpan<BusId> GetBusesByStop(StopId stop) const;
+
+		size_t GetBusCount() const;
+		std::string_view GetBusName(BusId bus) const;
+		TypeRoute GetBusType(BusId bus) const;
+		IdSpan<StopId> GetBusStops(BusId bus) const;
+		IdSpan<double> GetBusDepartures(BusId bus) const;
+		// Whether any bus has a timetable
+		bool HasDepartures() const;
+
+		// The position of the stop or bus among all of them sorted by name,
+		// so rank(a) < rank(b) exactly when the name of a is less than the
+		// name of b. Ranks may change when a stop or bus is added
+		uint64_t GetStopNameRank(StopId stop) const;
+		uint64_t GetBusNameRank(BusId bus) const;
+
+		// All buses and stops sorted by name. The views stay valid
+		// until the next AddBus or AddStop
+		IdSpan<BusId> GetAllBuses() const;
+		IdSpan<StopId> GetAllStops() const;
+
+		// Stores every array of the catalogue as it is, indexes included,
+		// so that Load only copies them back. Load replaces the contents
+		// of the catalogue and throws snapshot::SnapshotError if the arrays
+		// do not fit together
+		void Save(snapshot::Writer& writer) const;
+		void Load(snapshot::Reader& reader);
 
 	private:
-		std::deque<Stop> stops_;
-		std::unordered_map<std::string_view, const Stop*> stop_to_ptr_stop_;
-		std::deque<Bus> buses_;
-		std::unordered_map<std::string_view, const Bus*> bus_to_ptr_bus_;
-		std::unordered_map<const Stop*, std::unordered_set<const Bus*>> stop_to_buses_;
-
-		class HasherDistance {
-		public:
-			size_t operator()(std::pair<const Stop*, const Stop*> key) const {
-				return hasher_(key.first) + hasher_(key.second) * 16;
-			}
-		private:
-			std::hash<const Stop*> hasher_;
+		// Stops, indexed by StopId. The name index and the ranks are
+		// sorted on the first read after a stop is added, so loading
+		// appends ids and sorts them once
+		NamePool stop_names_;
+		mutable std::vector<uint64_t> stop_name_ranks_;
+		std::vector<double> stop_latitudes_;
+		std::vector<double> stop_longitudes_;
+		// Sorted by bus name together with the bus index
+		mutable std::vector<std::vector<BusId>> stop_to_buses_;
+		RoadDistances distances_;
+		mutable std::vector<StopId> stops_by_name_;
+		mutable bool is_stop_index_stale_ = false;
+
+		// Buses, indexed by BusId. Stops of bus b are
+		// bus_stops_[bus_stop_offsets_[b] .. bus_stop_offsets_[b + 1])
+		NamePool bus_names_;
+		mutable std::vector<uint64_t> bus_name_ranks_;
+		std::vector<TypeRoute> bus_types_;
+		std::vector<size_t> bus_stop_offsets_ = { 0 };
+		std::vector<StopId> bus_stops_;
+		// The same for departures
+		std::vector<size_t> bus_departure_offsets_ = { 0 };
+		std::vector<double> bus_departures_;
+		// The same as for stops
+		mutable std::vector<BusId> buses_by_name_;
+		mutable bool is_bus_index_stale_ = false;
+
+		struct BusStats {
+			size_t unique_stops = 0;
+			double geo_length = 0;
+			// Empty while some distance of the route is unknown
+			std::optional<double> route_length;
 		};
+		std::vector<BusStats> bus_stats_;
+
+		static void SortByName(const NamePool& names, std::vector<uint32_t>& sorted_ids,
+			std::vector<uint64_t>& ranks);
+		void UpdateStopIndex() const;
+		void UpdateBusIndex() const;
+		size_t CalculateUniqueStops(BusId bus) const;
+		std::optional<double> CalculateFactLenghtRoute(BusId bus) const;
+		double CalculateGeoLenghtRoute(BusId bus) const;
+	};
 
-		std::unordered_map<std::pair<const Stop*, const Stop*>,	size_t, HasherDistance> distances_;
+	// Orders buses and stops by name through their name ranks
+	class CompareBuses {
+	public:
+		explicit CompareBuses(const TransportCatalogue& catalogue);
+		bool operator()(BusId l, BusId r) const;
+	private:
+		const TransportCatalogue& catalogue_;
+	};
 
-		size_t CalculateUniqueStops(std::string_view bus) const;
-		double CalculateFactLenghtRoute(std::string_view bus) const;
-		double CalculateGeoLenghtRoute(std::string_view bus) const;
+	class CompareStop {
+	public:
+		explicit CompareStop(const TransportCatalogue& catalogue);
+		bool operator()(StopId l, StopId r) const;
+	private:
+		const TransportCatalogue& catalogue_;
 	};
 
 } // namespace catalogue
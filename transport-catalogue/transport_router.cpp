@@ -1,6 +1,11 @@
 #include "transport_router.h"
+#include "a_star_engine.h"
+#include "contraction_engine.h"
+#include "dijkstra_engine.h"
 #include "router.h"
 
+#include <iterator>
+#include <stdexcept>
 #include <string_view>
 
 namespace catalogue {
@@ -11,56 +16,368 @@ namespace catalogue {
 	}
 
 	void TransportRouter::BuildGraphAndRouter() {
-		BuildVertexes();
+		BuildTimetable();
+		if (routing_settings_.engine == RouterEngine::RAPTOR) {
+			engine_.reset();
+			graph_.reset();
+			edges_info_.clear();
+			raptor_ = std::make_unique<RaptorEngine>(
+				catalogue_, routing_settings_.bus_velocity, routing_settings_.bus_wait_time);
+			return;
+		}
+
+		raptor_.reset();
+		if (routing_settings_.engine == RouterEngine::CONTRACTION_HIERARCHIES) {
+			BuildStopGraph();
+			engine_ = std::make_unique<ContractionEngine>(*graph_);
+			return;
+		}
+
+		BuildGraph();
+		switch (routing_settings_.engine) {
+		case RouterEngine::ALL_PAIRS:
+			engine_ = std::make_unique<RoutesTable>(*graph_, routing_settings_.build_threads);
+			break;
+		case RouterEngine::DIJKSTRA:
+			engine_ = std::make_unique<DijkstraEngine>(*graph_, routing_settings_.route_cache_size);
+			break;
+		case RouterEngine::A_STAR:
+			engine_ = std::make_unique<AStarEngine>(*graph_, GetVertexCoordinates(), 0);
+			break;
+		case RouterEngine::ALT:
+			engine_ = std::make_unique<AStarEngine>(*graph_, GetVertexCoordinates(), routing_settings_.landmark_count);
+			break;
+		case RouterEngine::CONTRACTION_HIERARCHIES:
+		case RouterEngine::RAPTOR:
+			break;
+		}
+	}
+
+	void TransportRouter::BuildTimetable() {
+		timetable_.reset();
+		if (catalogue_.HasDepartures()) {
+			timetable_ = std::make_unique<ConnectionScanEngine>(
+				catalogue_, routing_settings_.bus_velocity, routing_settings_.bus_wait_time);
+		}
+	}
 
-		size_t number_all_stops = stop_to_pair_vertex_.size();
-		graph_ = std::make_unique<Graph>(Graph(2 * number_all_stops));
+	std::vector<geo::Coordinates> TransportRouter::GetVertexCoordinates() const {
+		std::vector<geo::Coordinates> coordinates(graph_->GetVertexCount());
+		for (StopId stop = 0; stop < catalogue_.GetStopCount(); ++stop) {
+			coordinates[BeginWait(stop)] = catalogue_.GetStopCoordinates(stop);
+			coordinates[EndWait(stop)] = catalogue_.GetStopCoordinates(stop);
+		}
+		return coordinates;
+	}
+
+	void TransportRouter::BuildGraph() {
+		engine_.reset();
+		ride_stops_.clear();
+		const size_t number_all_stops = catalogue_.GetStopCount();
+		Graph graph(2 * number_all_stops);
 		edges_info_.reserve(2 * number_all_stops);
 
-		for (const auto& [stop, pair_vertexes] : stop_to_pair_vertex_) {
-			graph_->AddEdge(graph::Edge<double>{
-				pair_vertexes.begin_wait, pair_vertexes.end_wait, routing_settings_.bus_wait_time
+		for (StopId stop = 0; stop < number_all_stops; ++stop) {
+			graph.AddEdge(graph::Edge<double>{
+				BeginWait(stop), EndWait(stop), routing_settings_.bus_wait_time
 			});
 			edges_info_.push_back(EdgeWaitInfo{ stop, routing_settings_.bus_wait_time });
 		}
 
-		for (const Bus* bus : catalogue_.GetAllBuses()) {
-			if (bus->type_route == TypeRoute::CIRCLE) {
-				AddEdgeBusInfo(bus->stops.begin(), bus->stops.end(), bus);
+		for (BusId bus = 0; bus < catalogue_.GetBusCount(); ++bus) {
+			const IdSpan<StopId> stops = catalogue_.GetBusStops(bus);
+			if (catalogue_.GetBusType(bus) == TypeRoute::CIRCLE) {
+				AddEdgeBusInfo(graph, stops.begin(), stops.end(), bus);
+			}
+			else {
+				const std::reverse_iterator<const StopId*> rbegin(stops.end());
+				const std::reverse_iterator<const StopId*> rend(stops.begin());
+				size_t half = (stops.size() + 1) / 2;
+				auto middle_it = std::next(stops.begin(), half);
+				auto rmiddle_it = std::next(rbegin, half);
+				AddEdgeBusInfo(graph, stops.begin(), middle_it, bus);
+				AddEdgeBusInfo(graph, rmiddle_it - 1, rend, bus);
+			}
+		}
+		graph_ = std::make_unique<FrozenGraph>(graph);
+	}
+
+	// The same directions BuildGraph takes: a circular bus goes through all
+	// its stops, a direct one goes through the first half of them there and
+	// back
+	void TransportRouter::BuildStopGraph() {
+		engine_.reset();
+		edges_info_.clear();
+		ride_stops_.clear();
+		const size_t stop_count = catalogue_.GetStopCount();
+
+		size_t ride_stop_count = 0;
+		for (BusId bus = 0; bus < catalogue_.GetBusCount(); ++bus) {
+			const size_t size = catalogue_.GetBusStops(bus).size();
+			ride_stop_count += catalogue_.GetBusType(bus) == TypeRoute::CIRCLE ? size : 2 * ((size + 1) / 2);
+		}
+		Graph graph(stop_count + ride_stop_count);
+		ride_stops_.reserve(ride_stop_count);
+
+		for (BusId bus = 0; bus < catalogue_.GetBusCount(); ++bus) {
+			const IdSpan<StopId> stops = catalogue_.GetBusStops(bus);
+			if (catalogue_.GetBusType(bus) == TypeRoute::CIRCLE) {
+				AddRideStops(graph, stops.begin(), stops.end(), bus);
 			}
 			else {
-				size_t half = (bus->stops.size() + 1) / 2;
-				auto middle_it = std::next(bus->stops.begin(), half);
-				auto rmiddle_it = std::next(bus->stops.rbegin(), half);
-				AddEdgeBusInfo(bus->stops.begin(), middle_it, bus);
-				AddEdgeBusInfo(rmiddle_it - 1, bus->stops.rend(), bus);
+				const size_t half = (stops.size() + 1) / 2;
+				const std::reverse_iterator<const StopId*> rend(stops.begin());
+				AddRideStops(graph, stops.begin(), stops.begin() + half, bus);
+				AddRideStops(graph, rend - half, rend, bus);
 			}
 		}
-		router_ = std::make_unique<Router>(Router(*graph_));
+		graph_ = std::make_unique<FrozenGraph>(graph);
 	}
 
-	void TransportRouter::BuildVertexes() {
-		size_t count_vertex = 0;
-		for (const Stop* stop : catalogue_.GetAllStops()) {
-			stop_to_pair_vertex_.insert({ stop, PairVertexesId{ count_vertex++, count_vertex++ } });
+	// The route leaves a stop vertex only to board a bus and comes back to
+	// one when it gets off, so every ride between the two becomes one item
+	RouteStat TransportRouter::MakeStopGraphRoute(const RouteEngine::RouteInfo& route) const {
+		const VertexId stop_count = catalogue_.GetStopCount();
+		RouteStat stat;
+		VertexId board = 0;
+		for (const EdgeId edge_id : route.edges) {
+			const graph::Edge<double> edge = graph_->GetEdge(edge_id);
+			if (edge.from < stop_count) {
+				board = edge.to - stop_count;
+				stat.items.push_back(EdgeWaitInfo{ static_cast<StopId>(edge.from), routing_settings_.bus_wait_time });
+			}
+			else if (edge.to < stop_count) {
+				const VertexId alight = edge.from - stop_count;
+				const uint64_t distance = ride_stops_[alight].distance - ride_stops_[board].distance;
+				stat.items.push_back(EdgeBusInfo{
+					ride_stops_[alight].bus, double(distance) / routing_settings_.bus_velocity, alight - board
+				});
+			}
+		}
+		stat.total_time = SumItemWeights(stat.items);
+		return stat;
+	}
+
+	void TransportRouter::BuildGraphAndRouter(const std::string& routes_file) {
+		if (routing_settings_.engine != RouterEngine::ALL_PAIRS
+			&& routing_settings_.engine != RouterEngine::CONTRACTION_HIERARCHIES) {
+			BuildGraphAndRouter();
+			return;
+		}
+
+		const uint64_t fingerprint = ComputeFingerprint();
+		if (Load(routes_file, fingerprint)) {
+			BuildTimetable();
+			return;
 		}
+		BuildGraphAndRouter();
+		Save(routes_file, fingerprint);
 	}
 
-	std::optional<graph::Router<double>::RouteInfo> TransportRouter::BuildRoute(
-		std::string_view stop_from, std::string_view stop_to) const {
-		if (!router_) {
+	namespace {
+		constexpr std::string_view ROUTES_FILE_KIND = "transport router";
+
+		enum class EdgeKind : uint8_t {
+			WAIT,
+			BUS
+		};
+	}
+
+	// The size of the route cache and the number of threads do not change
+	// what is saved
+	uint64_t TransportRouter::ComputeFingerprint() const {
+		snapshot::Writer writer;
+		catalogue_.Save(writer);
+		const uint32_t engine = static_cast<uint32_t>(routing_settings_.engine);
+		writer.Write(&routing_settings_.bus_velocity, 1);
+		writer.Write(&routing_settings_.bus_wait_time, 1);
+		writer.Write(&engine, 1);
+		return writer.GetChecksum();
+	}
+
+	void TransportRouter::Save(const std::string& routes_file, uint64_t fingerprint) const {
+		snapshot::Writer writer;
+		writer.Write(ROUTES_FILE_KIND);
+		writer.Write(&fingerprint, 1);
+		if (routing_settings_.engine == RouterEngine::CONTRACTION_HIERARCHIES) {
+			static_cast<const ContractionEngine&>(*engine_).Save(writer);
+			writer.Save(routes_file);
+			return;
+		}
+
+		const size_t edge_count = graph_->GetEdgeCount();
+		std::vector<uint64_t> edge_ends;
+		std::vector<double> edge_weights;
+		std::vector<EdgeKind> kinds;
+		std::vector<uint32_t> ids;
+		std::vector<uint32_t> span_counts;
+		edge_ends.reserve(2 * edge_count);
+		for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+			const graph::Edge<double> edge = graph_->GetEdge(edge_id);
+			edge_ends.push_back(edge.from);
+			edge_ends.push_back(edge.to);
+			edge_weights.push_back(edge.weight);
+
+			if (const auto* wait = std::get_if<EdgeWaitInfo>(&edges_info_[edge_id])) {
+				kinds.push_back(EdgeKind::WAIT);
+				ids.push_back(wait->stop);
+				span_counts.push_back(0);
+			}
+			else {
+				const EdgeBusInfo& bus = std::get<EdgeBusInfo>(edges_info_[edge_id]);
+				kinds.push_back(EdgeKind::BUS);
+				ids.push_back(bus.bus);
+				span_counts.push_back(static_cast<uint32_t>(bus.span_count));
+			}
+		}
+		writer.Write(edge_ends);
+		writer.Write(edge_weights);
+		writer.Write(kinds);
+		writer.Write(ids);
+		writer.Write(span_counts);
+		static_cast<const RoutesTable&>(*engine_).Save(writer);
+
+		writer.Save(routes_file);
+	}
+
+	bool TransportRouter::Load(const std::string& routes_file, uint64_t fingerprint) {
+		try {
+			snapshot::Reader reader(routes_file);
+			std::vector<uint64_t> file_fingerprint;
+			if (reader.ReadText() != ROUTES_FILE_KIND) {
+				return false;
+			}
+			reader.Read(file_fingerprint);
+			if (file_fingerprint.size() != 1 || file_fingerprint[0] != fingerprint) {
+				return false;
+			}
+
+			// The graph of the stops is quick to build again, only the
+			// hierarchy is kept in the file
+			if (routing_settings_.engine == RouterEngine::CONTRACTION_HIERARCHIES) {
+				BuildStopGraph();
+				auto engine = std::make_unique<ContractionEngine>(*graph_, reader);
+				if (!reader.AtEnd()) {
+					return false;
+				}
+				engine_ = std::move(engine);
+				return true;
+			}
+
+			std::vector<uint64_t> edge_ends;
+			std::vector<double> edge_weights;
+			std::vector<EdgeKind> kinds;
+			std::vector<uint32_t> ids;
+			std::vector<uint32_t> span_counts;
+			reader.Read(edge_ends);
+			reader.Read(edge_weights);
+			reader.Read(kinds);
+			reader.Read(ids);
+			reader.Read(span_counts);
+
+			const size_t vertex_count = 2 * catalogue_.GetStopCount();
+			const size_t edge_count = edge_weights.size();
+			if (edge_ends.size() != 2 * edge_count || kinds.size() != edge_count
+				|| ids.size() != edge_count || span_counts.size() != edge_count) {
+				return false;
+			}
+
+			// The checksum only catches damage, so every id is checked before
+			// it is used: a wait goes from one vertex of its stop to the other,
+			// a ride does not pass more stops than its bus has
+			Graph built_graph(vertex_count);
+			std::vector<EdgeInfo> edges_info;
+			edges_info.reserve(edge_count);
+			for (EdgeId edge_id = 0; edge_id < edge_count; ++edge_id) {
+				const VertexId from = edge_ends[2 * edge_id];
+				const VertexId to = edge_ends[2 * edge_id + 1];
+				if (from >= vertex_count || to >= vertex_count || !(edge_weights[edge_id] >= 0)) {
+					return false;
+				}
+				built_graph.AddEdge(graph::Edge<double>{ from, to, edge_weights[edge_id] });
+
+				if (kinds[edge_id] == EdgeKind::WAIT) {
+					const StopId stop = ids[edge_id];
+					if (stop >= catalogue_.GetStopCount() || from != BeginWait(stop) || to != EndWait(stop)) {
+						return false;
+					}
+					edges_info.push_back(EdgeWaitInfo{ stop, edge_weights[edge_id] });
+				}
+				else if (kinds[edge_id] == EdgeKind::BUS) {
+					const BusId bus = ids[edge_id];
+					if (bus >= catalogue_.GetBusCount() || span_counts[edge_id] == 0
+						|| span_counts[edge_id] >= catalogue_.GetBusStops(bus).size()) {
+						return false;
+					}
+					edges_info.push_back(EdgeBusInfo{ bus, edge_weights[edge_id], span_counts[edge_id] });
+				}
+				else {
+					return false;
+				}
+			}
+			auto graph = std::make_unique<FrozenGraph>(built_graph);
+
+			auto engine = std::make_unique<RoutesTable>(*graph, reader);
+			if (!reader.AtEnd()) {
+				return false;
+			}
+
+			engine_ = std::move(engine);
+			graph_ = std::move(graph);
+			edges_info_ = std::move(edges_info);
+			ride_stops_.clear();
+			return true;
+		}
+		catch (const snapshot::SnapshotError&) {
+			return false;
+		}
+		catch (const std::out_of_range&) {
+			return false;
+		}
+	}
+
+	std::optional<RouteStat> TransportRouter::BuildRoute(std::string_view stop_from,
+		std::string_view stop_to, std::optional<double> departure_time) const {
+		if (!engine_ && !raptor_) {
 			throw std::logic_error("Router no initialization");
 		}
 
-		const VertexId from = stop_to_pair_vertex_.at(catalogue_.FindStop(stop_from)).begin_wait;
-		const VertexId to = stop_to_pair_vertex_.at(catalogue_.FindStop(stop_to)).begin_wait;
+		const auto from_stop = catalogue_.FindStop(stop_from);
+		const auto to_stop = catalogue_.FindStop(stop_to);
+		if (!from_stop || !to_stop) {
+			return {};
+		}
 
-		auto route_info_ptr = router_->BuildRoute(from, to);
-		if (!route_info_ptr) {
+		if (departure_time && timetable_) {
+			return timetable_->BuildRoute(*from_stop, *to_stop, *departure_time);
+		}
+		if (raptor_) {
+			return raptor_->BuildRoute(*from_stop, *to_stop);
+		}
+
+		if (routing_settings_.engine == RouterEngine::CONTRACTION_HIERARCHIES) {
+			const auto route = engine_->BuildRoute(*from_stop, *to_stop);
+			if (!route) {
+				return {};
+			}
+			return MakeStopGraphRoute(*route);
+		}
+
+		const auto route = engine_->BuildRoute(BeginWait(*from_stop), BeginWait(*to_stop));
+		if (!route) {
 			return {};
 		}
+		RouteStat stat;
+		stat.items.reserve(route->edges.size());
+		for (const EdgeId edge_id : route->edges) {
+			stat.items.push_back(edges_info_[edge_id]);
+		}
+		stat.total_time = SumItemWeights(stat.items);
+		return stat;
+	}
 
-		return router_->BuildRoute(from, to);
+	size_t TransportRouter::GetSettledCount() const {
+		return engine_ ? engine_->GetSettledCount() : 0;
 	}
 
 	const EdgeInfo& TransportRouter::GetEdgeInfo(const EdgeId edge_id) const {
@@ -1,12 +1,20 @@
 #pragma once
 
 #include "transport_catalogue.h"
+#include "connection_scan_engine.h"
+#include "frozen_graph.h"
 #include "graph.h"
+#include "raptor_engine.h"
+#include "route_engine.h"
 #include "router.h"
+#include "routes_table.h"
+#include "snapshot.h"
 
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
-#include <unordered_map>
 #include <optional>
 
 namespace catalogue {
@@ -14,77 +22,158 @@ namespace catalogue {
 	using EdgeId = size_t;
 	using VertexId = size_t;
 
-	struct EdgeWaitInfo {
-		const Stop* stop = nullptr;
-		double weight = 0;
+	enum class RouterEngine {
+		// Routes between all pairs of stops are found in advance
+		ALL_PAIRS,
+		// Every route is searched for when it is requested
+		DIJKSTRA,
+		// Shortcuts are added in advance, so that a search on request only
+		// visits a small part of the graph. The graph is built from the
+		// consecutive stops of the buses, see BuildStopGraph
+		CONTRACTION_HIERARCHIES,
+		// The search on request goes towards the last stop first, using the
+		// distance as the crow flies
+		A_STAR,
+		// A_STAR that also uses the routes to and from a few landmarks,
+		// found in advance
+		ALT,
+		// No graph: every route is searched for when it is requested by
+		// riding the buses stop by stop
+		RAPTOR
 	};
 
-	struct EdgeBusInfo {
-		const Bus* bus = nullptr;
-		double weight = 0;
-		size_t span_count = 0;
-	};
-
-	using EdgeInfo = std::variant<EdgeWaitInfo, EdgeBusInfo>;
-
 	struct RoutingSettings {
 		double bus_velocity = 1000; // meters per minute
 		double bus_wait_time = 6; // minute
-	};
-
-	struct PairVertexesId {
-		VertexId begin_wait;
-		VertexId end_wait;
+		RouterEngine engine = RouterEngine::ALL_PAIRS;
+		// Routes remembered by an engine that searches on request
+		size_t route_cache_size = 4096;
+		size_t landmark_count = 16;
+		// Threads building the all-pairs table, 0 means one per core
+		size_t build_threads = 0;
 	};
 
 	class TransportRouter {
 		using VertexId = size_t;
 		using Graph = graph::DirectedWeightedGraph<double>;
-		using Router = graph::Router<double>;
 	
 	public:
 		TransportRouter(const TransportCatalogue& catalogue, RoutingSettings routing_settings);
 
 		void BuildGraphAndRouter();
 
-		std::optional<graph::Router<double>::RouteInfo> BuildRoute(
-			std::string_view stop_from, std::string_view stop_to) const;
-
+		// Takes the graph and what the engine prepared in advance from
+		// routes_file if it was made for the same catalogue and routing
+		// settings. Otherwise, including when the file is missing or damaged,
+		// builds them and rewrites the file. Only the all-pairs and the
+		// contraction hierarchies engines use the file; the others prepare
+		// little and ignore it
+		void BuildGraphAndRouter(const std::string& routes_file);
+
+		// With departure_time (minutes from the start of the day), when some
+		// bus has a timetable, the buses with timetables are taken when they
+		// leave and the others after bus_wait_time. Otherwise waiting for any
+		// bus takes bus_wait_time
+		std::optional<RouteStat> BuildRoute(std::string_view stop_from, std::string_view stop_to,
+			std::optional<double> departure_time = std::nullopt) const;
+
+		// Vertices settled by the engine for the last route, 0 with the
+		// RAPTOR engine and when the route came from a table or a cache
+		size_t GetSettledCount() const;
+
+		// There are no such edges with the RAPTOR and the contraction
+		// hierarchies engines
 		const EdgeInfo& GetEdgeInfo(const EdgeId edge_id) const;
 
 	private:
 		const TransportCatalogue& catalogue_;
-		std::unique_ptr<Graph> graph_;
-		std::unique_ptr<Router> router_;
+		// Edges are added to a Graph, which is then frozen
+		std::unique_ptr<FrozenGraph> graph_;
+		std::unique_ptr<RouteEngine> engine_;
+		std::unique_ptr<RaptorEngine> raptor_;
+		// Set when some bus has a timetable
+		std::unique_ptr<ConnectionScanEngine> timetable_;
 		RoutingSettings routing_settings_;
-		std::unordered_map<const Stop*, PairVertexesId> stop_to_pair_vertex_;
 		std::vector<EdgeInfo> edges_info_;
 
-		void BuildVertexes();
+		// A stop of a bus in the graph of BuildStopGraph. distance is the
+		// road distance from the first stop of the bus direction
+		struct RideStop {
+			BusId bus;
+			uint64_t distance;
+		};
+		// Vertex GetStopCount() + i of that graph is ride_stops_[i]
+		std::vector<RideStop> ride_stops_;
+
+		// Every stop has two vertices: a passenger arrives at the first one
+		// and boards a bus from the second one after waiting
+		static VertexId BeginWait(StopId stop) {
+			return 2 * static_cast<VertexId>(stop);
+		}
+
+		static VertexId EndWait(StopId stop) {
+			return 2 * static_cast<VertexId>(stop) + 1;
+		}
 
+		void BuildGraph();
+		// Every stop is a vertex, and so is every stop of every bus direction.
+		// A direction is a chain of ride edges between its consecutive stops;
+		// boarding it from a stop weighs bus_wait_time and leaving it weighs
+		// nothing. Unlike BuildGraph, the edges grow linearly with the length
+		// of the buses, which keeps contraction hierarchies small
+		void BuildStopGraph();
 		template<typename Iter>
-		void AddEdgeBusInfo(Iter first, Iter last, const Bus* bus);
+		void AddRideStops(Graph& graph, Iter first, Iter last, BusId bus);
+		RouteStat MakeStopGraphRoute(const RouteEngine::RouteInfo& route) const;
+		void BuildTimetable();
+		std::vector<geo::Coordinates> GetVertexCoordinates() const;
+		template<typename Iter>
+		void AddEdgeBusInfo(Graph& graph, Iter first, Iter last, BusId bus);
+
+		// Depends on everything the graph is built from
+		uint64_t ComputeFingerprint() const;
+		void Save(const std::string& routes_file, uint64_t fingerprint) const;
+		bool Load(const std::string& routes_file, uint64_t fingerprint);
 	};
 
 	template<typename Iter>
-	void TransportRouter::AddEdgeBusInfo(Iter first, Iter last, const Bus* bus) {
+	void TransportRouter::AddEdgeBusInfo(Graph& graph, Iter first, Iter last, BusId bus) {
 
 		for (auto from = first; from != last; ++from) {
 			size_t distance = 0;
 			size_t span_count = 0;
-			VertexId from_vertex = stop_to_pair_vertex_.at(*from).end_wait;
+			VertexId from_vertex = EndWait(*from);
 			for (auto to = std::next(from); to != last; ++to) {
 				auto before_to = std::prev(to);
-				distance += catalogue_.GetDistance((*before_to)->name, (*to)->name);
+				distance += catalogue_.GetDistance(*before_to, *to);
 				++span_count;
 
-				VertexId to_vertex = stop_to_pair_vertex_.at(*to).begin_wait;
+				VertexId to_vertex = BeginWait(*to);
 				double weight = double(distance) / routing_settings_.bus_velocity;
 
-				graph_->AddEdge(graph::Edge<double>{ from_vertex, to_vertex, weight });
+				graph.AddEdge(graph::Edge<double>{ from_vertex, to_vertex, weight });
 				edges_info_.push_back(EdgeBusInfo{ bus, weight, span_count });
 			}
 		}
 	}
 
+	template<typename Iter>
+	void TransportRouter::AddRideStops(Graph& graph, Iter first, Iter last, BusId bus) {
+		const VertexId stop_count = catalogue_.GetStopCount();
+		uint64_t distance = 0;
+		for (auto it = first; it != last; ++it) {
+			const VertexId ride_vertex = stop_count + ride_stops_.size();
+			if (it != first) {
+				const uint64_t span = catalogue_.GetDistance(*std::prev(it), *it);
+				distance += span;
+				graph.AddEdge(graph::Edge<double>{ ride_vertex - 1, ride_vertex, double(span) / routing_settings_.bus_velocity });
+				graph.AddEdge(graph::Edge<double>{ ride_vertex, *it, 0 });
+			}
+			if (std::next(it) != last) {
+				graph.AddEdge(graph::Edge<double>{ *it, ride_vertex, routing_settings_.bus_wait_time });
+			}
+			ride_stops_.push_back(RideStop{ bus, distance });
+		}
+	}
+
 } // namespace catalogue